@@ -0,0 +1,93 @@
+--[[
+  mathbench.lua
+
+  Made by DoelJavid for V-GAME.
+
+  https://github.com/DoelJavid/v-game
+]]
+
+-------------------------------------------------------------------------------
+--[[ Benchmarks ]]--
+
+local ITERATIONS = 2000000
+
+--[[
+  Returns how long calling `f` on every iteration of a tight loop takes, in
+  milliseconds. The results are summed so the loop can't be optimized away.
+]]
+function timeUnary(f)
+  local sum = 0
+  local start = system.clock()
+  for i = 1, ITERATIONS do
+    sum = sum + f(i * 0.001)
+  end
+  return (system.clock() - start) * 1000, sum
+end
+
+--[[
+  Like `timeUnary()`, but for functions taking two numbers.
+]]
+function timeBinary(f)
+  local sum = 0
+  local start = system.clock()
+  for i = 1, ITERATIONS do
+    sum = sum + f(i * 0.001, 0.5)
+  end
+  return (system.clock() - start) * 1000, sum
+end
+
+--[[
+  Returns how long a helper games used to write themselves takes compared to
+  the built-in version.
+]]
+function timeHelper(f)
+  local sum = 0
+  local start = system.clock()
+  for i = 1, ITERATIONS do
+    sum = sum + f(i * 0.001 - 1000, -500, 500)
+  end
+  return (system.clock() - start) * 1000, sum
+end
+
+--[[
+  Clamps `x` between `m` and `n` the way games did before `math.clamp()`.
+]]
+function clamp(x, m, n)
+  return math.max(m, math.min(n, x))
+end
+
+-------------------------------------------------------------------------------
+----[[ Main ]]----
+
+local unary = { "abs", "cos", "exp", "floor", "sin", "sqrt", "tan" }
+local binary = { "atan2", "max", "min" }
+
+--[[
+  Rounds the given number of milliseconds to two decimal places.
+]]
+local function milliseconds(ms)
+  return math.round(ms * 100) / 100
+end
+
+--[[
+  Logs how long a function took before and after the math library moved to
+  Lua's built-in functions.
+]]
+local function report(name, old, new)
+  system.log(name .. ": f32 " .. milliseconds(old) .. " ms, native "
+    .. milliseconds(new) .. " ms, " .. milliseconds(old / new) .. "x faster")
+end
+
+system.log("Timing " .. ITERATIONS .. " calls per function...")
+
+for _, name in ipairs(unary) do
+  report(name, timeUnary(math.f32[name]), timeUnary(math[name]))
+end
+
+for _, name in ipairs(binary) do
+  report(name, timeBinary(math.f32[name]), timeBinary(math[name]))
+end
+
+report("clamp", timeHelper(clamp), timeHelper(math.clamp))
+
+system.exit()
@@ -40,295 +40,148 @@ function loopNumber(x, m, n)
   return result
 end
 
---[[
-  Attempts to find the first occurance of a value within the given array `arr`
-  and removes it if it's found.
-]]
-function removeFromArray(value, arr)
-  local itemFound = false
-
-  for idx, item in ipairs(arr) do
-    if itemFound then
-      arr[idx] = arr[idx + 1]
-    else
-      if item == value then
-        itemFound = true
-        arr[idx] = arr[idx + 1]
-      end
-    end
-  end
-end
-
 -------------------------------------------------------------------------------
-----[[ Point Utility Class ]]----
+----[[ Screen Space ]]----
+
+local screen = mat3()
 
 --[[
-  Creates a new point at the given x and y positions.
+  Updates the transform from game space to screen space, which keeps anything
+  from looking stretched out on screen.
 ]]
-function Point(x, y)
-  x = x or 0
-  y = y or x
-
-  assert(type(x) == "number", "Expected `x` to be a number!")
-  assert(type(y) == "number", "Expected `y` to be a number!")
-
-  local point = {
-    __type = "Point",
-    X = x,
-    Y = y
-  }
-
-  --[[
-    Rotates the point using the given rotation in radians. Optionally, this
-    function can take an extra point to pivot around.
-  ]]
-  function point:Rotate(rotation, pivot)
-    pivot = pivot or Point()
-
-    assert(type(rotation) == "number", "Expected `rotation` to be a number!")
-    assert(type(pivot) == "Point", "Expected `pivot` to be a point!")
-
-    local movedPoint = Point(self.X - pivot.X, self.Y - pivot.Y)
-    local xAlignment = math.cos(rotation)
-    local yAlignment = math.sin(rotation)
-
-    return Point(
-      movedPoint.X * xAlignment - movedPoint.Y * yAlignment + pivot.X,
-      movedPoint.X * yAlignment + movedPoint.Y * xAlignment + pivot.Y
-    )
-  end
-
-  --[[
-    Returns a new point that's equal to the current point multiplied by the
-    given scale.
-  ]]
-  function point:Scale(factor)
-    assert(type(factor) == "number", "Expected `factor` to be a number!")
-    return Point(self.X * factor, self.Y * factor)
-  end
-
-  --[[
-    Returns a new point that's equal to the sum of the current point and
-    another given point.
-  ]]
-  function point:Add(other)
-    assert(type(other) == "Point", "Expected `other` to be a point!")
-    return Point(self.X + other.X, self.Y + other.Y)
-  end
-
-  --[[
-    Linear interpolates the point between itself and another given point using
-    `t` and returns a new point containing the result.
-  ]]
-  function point:Lerp(other, t)
-    assert(type(other) == "Point", "Expected `other` to be a point!")
-    assert(type(t) == "number", "Expected `t` to be a number!")
-    return Point(
-      self.X + (other.X - self.X) * t,
-      self.Y + (other.Y - self.Y) * t
-    )
-  end
-
-  --[[
-    Gets the distance between the point and (0, 0).
-  ]]
-  function point:Distance()
-    return math.sqrt(self.X * self.X + self.Y * self.Y)
-  end
-
-  --[[
-    Returns a unit point of the given point. A unit point is a point in which
-    the distance from the center is exactly 1.
-  ]]
-  function point:Unit()
-    local distance = self:Distance()
-    return Point(self.X / distance, self.Y / distance)
-  end
-
-  --[[
-    Unwraps the point into a tuple of two numbers.
-  ]]
-  function point:Unwrap()
-    return self.X, self.Y
-  end
+function updateScreen()
+  local aspect = graphics.aspect()
+  screen:identity():translate((1 - aspect) / 2, 0):scale(aspect, 1)
+end
 
-  --[[
-    Returns an identical duplicate of the given point.
-  ]]
-  function point:Clone()
-    return Point(self.X, self.Y)
-  end
+-------------------------------------------------------------------------------
+----[[ Bullets & Bullet Management ]]----
 
-  --[[
-    Returns the point translated to screen space. This function is used to
-    ensure that nothing looks stretched out on screen.
-  ]]
-  function point:ToScreenSpace()
-    local aspect = graphics.aspect()
-    return Point(self.X * aspect + ((1 - aspect) / 2), self.Y)
-  end
+local bullets = table.new(32, 0)
 
-  return point
-end
+local Bullet = class("Bullet")
 
 --[[
-  Sets the graphics position to the position of the given point.
+  Sets up a new bullet with the given position and velocity.
 ]]
-function graphics.moveToPoint(point)
-  assert(type(point) == "Point", "Expected `point` to be a Point!")
-  graphics.move(point:Unwrap())
+function Bullet:init(position, velocity)
+  assert(vec2.is(position), "Expected `position` to be a vec2!")
+  assert(vec2.is(velocity), "Expected `velocity` to be a vec2!")
+
+  self.Position = position:copy()
+  self.Velocity = velocity:copy()
 end
 
 --[[
-  Draws a line to the screen between the current graphics position and the
-  given point.
+  Updates the bullet. Returns false once the bullet leaves the screen.
 ]]
-function graphics.plotPoint(point)
-  assert(type(point) == "Point", "Expected `point` to be a Point!")
-  graphics.plot(point:Unwrap())
+function Bullet:Update()
+  self.Position:add(self.Velocity)
+
+  return
+    self.Position.x >= -0.05 and self.Position.x <= 1.05 and
+    self.Position.y >= -0.05 and self.Position.y <= 1.05
 end
 
 --[[
-  Converts the given rotation to a point.
+  Draws the bullet.
 ]]
-function pointFromRotation(rotation)
-  assert(type(rotation) == "number", "Expected `rotation` to be a number!")
-  return Point(math.cos(rotation), math.sin(rotation))
-end
-
--------------------------------------------------------------------------------
-----[[ Bullets & Bullet Management ]]----
+function Bullet:Draw()
+  local tail = self.Velocity:copy():normalize():scale(0.02):add(self.Position)
 
-local bullets = {}
+  graphics.move(screen * self.Position)
+  graphics.plot(screen:apply(tail))
+end
 
 --[[
   Creates a new bullet instance with the given position and velocity.
 ]]
 function fireBullet(position, velocity)
-  assert(type(position) == "Point", "Expected `position` to be a Point!")
-  assert(type(velocity) == "Point", "Expected `velocity` to be a Point!")
-
-  local bullet = {
-    __type = "Bullet",
-    Position = position:Clone(),
-    Velocity = velocity:Clone()
-  }
-
-  --[[
-    Updates the bullet.
-  ]]
-  function bullet:Update()
-    self.Position = self.Position:Add(self.Velocity)
-
-    if
-      self.Position.X < -0.05 or self.Position.X > 1.05 or
-      self.Position.Y < -0.05 or self.Position.Y > 1.05
-    then
-      removeFromArray(self, bullets)
-    end
-  end
-
-  --[[
-    Draws the bullet.
-  ]]
-  function bullet:Draw()
-    local screenPosition = self.Position:ToScreenSpace()
-    local direction = self.Velocity:Unit()
-
-    graphics.moveToPoint(screenPosition)
-    graphics.plotPoint(screenPosition:Add(direction:Scale(0.02)))
-  end
-
-  bullets[#bullets + 1] = bullet
+  bullets[#bullets + 1] = Bullet(position, velocity)
 end
 
 --[[
   Updates and draws all bullets within the game.
 ]]
 function updateBullets()
-  for _, bullet in ipairs(bullets) do
-    bullet:Update()
-    bullet:Draw()
+  -- Going backwards, so swapping the last bullet into a removed bullet's place
+  -- never skips one.
+  for i = #bullets, 1, -1 do
+    local bullet = bullets[i]
+    if bullet:Update() then
+      bullet:Draw()
+    else
+      table.swapremove(bullets, i)
+    end
   end
 end
 
 -------------------------------------------------------------------------------
 ----[[ Players ]]----
 
+-- The outline of a ship facing up, relative to its position.
+local SHIP_SHAPE = { vec2(0, 0.028), vec2(0.02, -0.028), vec2(-0.02, -0.028) }
+
+local Ship = class("Ship")
+
 --[[
-  Creates a new ship instance.
+  Sets up a new ship in the middle of the screen.
 ]]
-function Ship()
-  local ship = {
-    __type = "Ship",
-    Position = Point(0.5),
-    Velocity = Point(),
-    Speed = 0.05,
-    Rotation = 0,
-    Bullet = nil
-  }
-
-  --[[
-    Update process for the ship.
-  ]]
-  function ship:Update()
-    if input.pressed("Left") then
-    	self.Rotation = self.Rotation + 0.1
-    end
-
-    if input.pressed("Right") then
-    	self.Rotation = self.Rotation - 0.1
-    end
+function Ship:init()
+  self.Position = vec2(0.5, 0.5)
+  self.Velocity = vec2()
+  self.Speed = 0.05
+  self.Rotation = 0
+  self.Transform = mat3()
+  self.Outline = {}
+end
 
-    if input.pressed("Up") then
-      local targetVelocity = Point(0, self.Speed):Rotate(self.Rotation)
-      self.Velocity = self.Velocity:Lerp(targetVelocity, 0.005)
-      audio.blip(4, {Semitone = -250, Duration = 0.05, Volume = 0.1})
-    else
-      self.Velocity = self.Velocity:Lerp(Point(), 0.02)
-    end
+--[[
+  Update process for the ship.
+]]
+function Ship:Update()
+  if input.pressed("Left") then
+    self.Rotation = self.Rotation + 0.1
+  end
 
-    if input.tapped("A") then
-      fireBullet(self.Position, pointFromRotation(self.Rotation + math.PI / 2):Scale(0.02))
-      audio.blip(1, {Semitone = 23, Duration = 0.05, Volume = 0.25})
-    end
+  if input.pressed("Right") then
+    self.Rotation = self.Rotation - 0.1
+  end
 
-    self.Position.X =
-      loopNumber(self.Position.X + self.Velocity.X, 1.05, -0.05)
-    self.Position.Y =
-      loopNumber(self.Position.Y + self.Velocity.Y, 1.05, -0.05)
+  if input.pressed("Up") then
+    local targetVelocity = vec2(0, self.Speed):rotate(self.Rotation)
+    self.Velocity:lerp(targetVelocity, 0.005)
+    audio.blip(4, {Semitone = -250, Duration = 0.05, Volume = 0.1})
+  else
+    self.Velocity:scale(0.98)
   end
 
-  --[[
-    Draws the ship.
-  ]]
-  function ship:Draw()
-    local tip = self.Position:
-      Add(Point(0, 0.028)):
-      Rotate(self.Rotation, self.Position):
-      ToScreenSpace()
-
-    graphics.color(1)
-    graphics.moveToPoint(tip)
-
-    graphics.plotPoint(
-      self.Position:
-        Add(Point(0.02, -0.028)):
-        Rotate(self.Rotation, self.Position):
-        ToScreenSpace()
-    )
-
-    graphics.plotPoint(
-      self.Position:
-        Add(Point(-0.02, -0.028)):
-        Rotate(self.Rotation, self.Position):
-        ToScreenSpace()
-    )
-
-    graphics.plotPoint(tip)
+  if input.tapped("A") then
+    fireBullet(self.Position, vec2(0, 0.02):rotate(self.Rotation))
+    audio.blip(1, {Semitone = 23, Duration = 0.05, Volume = 0.25})
   end
 
-  return ship
+  self.Position.x =
+    loopNumber(self.Position.x + self.Velocity.x, 1.05, -0.05)
+  self.Position.y =
+    loopNumber(self.Position.y + self.Velocity.y, 1.05, -0.05)
+end
+
+--[[
+  Draws the ship.
+]]
+function Ship:Draw()
+  self.Transform:identity():
+    multiply(screen):
+    translate(self.Position.x, self.Position.y):
+    rotate(self.Rotation):
+    transformAll(SHIP_SHAPE, self.Outline)
+
+  graphics.color(1)
+  graphics.move(self.Outline[1])
+  graphics.plot(self.Outline[2])
+  graphics.plot(self.Outline[3])
+  graphics.plot(self.Outline[1])
 end
 
 local ship = Ship()
@@ -337,6 +190,7 @@ local ship = Ship()
 ----[[ Game Loop ]]----
 
 while true do
+  updateScreen()
   graphics.clear()
 
   ship:Update()
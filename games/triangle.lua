@@ -30,62 +30,43 @@ function loopNumber(x, m, n)
   return result
 end
 
---[[
-  Returns the given position rotated around 0, 0, or a pivot point if given.
-]]
-function rotatePoint(x, y, rotation, pivotX, pivotY)
-  pivotX = pivotX or 0
-  pivotY = pivotY or 0
-
-  assert(type(x) == "number", "Expected `x` to be a number!")
-  assert(type(y) == "number", "Expected `y` to be a number!")
-  assert(type(rotation) == "number", "Expected `rotation` to be a number!")
-  assert(type(pivotX) == "number", "Expected `pivotX` to be a number!")
-  assert(type(pivotY) == "number", "Expected `pivotY` to be a number!")
-
-  local movedX, movedY = x - pivotX, y - pivotY
-  local xAlignment = math.cos(rotation)
-  local yAlignment = math.sin(rotation)
-
-  return movedX * xAlignment - movedY * yAlignment + pivotX,
-    movedX * yAlignment + movedY * xAlignment + pivotY
-end
-
---[[
-  Returns a given position transformed to screen space.
-]]
-function pointToScreenSpace(x, y)
-  assert(type(x) == "number", "Expected `x` to be a number!")
-  assert(type(y) == "number", "Expected `y` to be a number!")
-  local aspect = graphics.aspect()
-  return x * aspect + ((1 - aspect) / 2), y
-end
-
 -------------------------------------------------------------------------------
 ----[[ Game Loop ]]----
 
 local rotation = 0
 local color = 1
 
-while true do
+local triangle = { vec2(0.25, 0.333), vec2(0.5, 0.767), vec2(0.75, 0.333) }
+local screen = {}
+local transform = mat3()
+
+--[[
+  Called by V-GAME once per tick with the length of a tick in seconds.
+]]
+function update(dt)
   rotation = rotation + 0.025
   color = loopNumber(color + 0.025, 8.999, 1)
+end
 
-  local startingX, startingY = pointToScreenSpace(
-    rotatePoint(0.25, 0.333, rotation, 0.5, 0.5)
-  )
+--[[
+  Called by V-GAME whenever a frame is about to be presented.
+]]
+function draw()
+  -- Spin the triangle around the center, then fit it to the screen.
+  local aspect = graphics.aspect()
+  transform:identity()
+    :translate((1 - aspect) / 2, 0)
+    :scale(aspect, 1)
+    :translate(0.5, 0.5)
+    :rotate(rotation)
+    :translate(-0.5, -0.5)
+  transform:transformAll(triangle, screen)
 
   graphics.clear()
   graphics.color(math.floor(color))
 
-  graphics.move(startingX, startingY)
-  graphics.plot(pointToScreenSpace(
-    rotatePoint(0.5, 0.767, rotation, 0.5, 0.5)
-  ))
-  graphics.plot(pointToScreenSpace(
-    rotatePoint(0.75, 0.333, rotation, 0.5, 0.5)
-  ))
-  graphics.plot(startingX, startingY)
-
-  graphics.draw()
+  graphics.move(screen[1])
+  graphics.plot(screen[2])
+  graphics.plot(screen[3])
+  graphics.plot(screen[1])
 end
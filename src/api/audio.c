@@ -7,93 +7,115 @@
 */
 
 #include "audio.h"
-
-static Sound channels[4] = {};
+#include "mixer.h"
+#include "bench.h"
+#include "trace.h"
+
+static AudioStream audio_stream;
+static short audio_scratch[AUDIO_BUFFER_FRAMES * 2];
+
+// The queue and mixer are shared with the audio device's thread, so only one
+// game per process can use them. Games that didn't call `audio_init()`, like
+// the ones the runner starts, drop every command instead.
+static INSTANCE_LOCAL bool audio_enabled = false;
+
+// The command queue is a single-producer/single-consumer ring buffer. The game
+// thread only ever writes the tail and the audio callback only ever writes the
+// head, so neither side needs a lock. Both indices live on their own cache
+// line so the two threads don't fight over them.
+static audio_command_t audio_queue[AUDIO_QUEUE_CAPACITY];
+static _Alignas(64) atomic_size_t audio_queue_head = 0;
+static _Alignas(64) atomic_size_t audio_queue_tail = 0;
+static atomic_size_t audio_queue_dropped = 0;
 
 /**
-  Generates a sample of a waveform for the given type.
-
-  Based on this code here:
-  https://github.com/mdcrtr/sound-generator/blob/main/src/sound_gen.c
+  Pushes a command to the audio queue. If the queue is full, the command is
+  dropped instead of waiting for the audio callback to catch up.
 */
-static float step_oscillator(int type, float step) {
-  switch (type) {
-  case 1: // Square Wave
-    return step < 0.5f ? -1.0f : 1.0f;
-  case 2: // Triangle Wave
-    return step < 0.5f ? 4.0f * step - 1.0f : 1.0f - 4.0f * (step - 0.5f);
-  case 3: // Sine Wave
-    return sinf(2.0f * PI * step);
-  default:
-    return sinf(powf(2.0f * PI * step, 3));
+static void audio_push_command(audio_command_t cmd) {
+  if (!audio_enabled)
+    return;
+
+  size_t tail = atomic_load_explicit(&audio_queue_tail, memory_order_relaxed);
+  size_t head = atomic_load_explicit(&audio_queue_head, memory_order_acquire);
+
+  if (tail - head == AUDIO_QUEUE_CAPACITY) {
+    atomic_fetch_add_explicit(&audio_queue_dropped, 1, memory_order_relaxed);
+    return;
   }
+
+  audio_queue[tail & (AUDIO_QUEUE_CAPACITY - 1)] = cmd;
+  atomic_store_explicit(&audio_queue_tail, tail + 1, memory_order_release);
 }
 
 /**
-  Generates a waveform using the given buffer, number of samples, and
-  configuration.
-
-  Based on this code here:
-  https://github.com/mdcrtr/sound-generator/blob/main/src/sound_gen.c
+  Applies a single command to the mixer. Only called by the audio callback.
 */
-static void
-generate_waveform(short* buffer, int samples, waveform_params_t params) {
-  float wave_step = ROOT_NOTE_FREQUENCY *
-                    powf(2.0f, (float)params.semitone / 12.0f) / SAMPLE_RATE;
-  float wave_index = 0.0f;
-
-  for (int i = 0; i < samples; i++) {
-    float sample = step_oscillator(params.type, wave_index);
-    sample *= params.volume;
-    buffer[i] = (short)(sample * 32767.0f);
-
-    wave_index += wave_step;
-    if (wave_index > 1.0f)
-      wave_index = 0.0f;
-
-    if (params.type > 3 && i % 64 == 0)
-      wave_index = (float)(rand() % 128) / 128;
+static void audio_apply_command(const audio_command_t* cmd) {
+  switch (cmd->id) {
+  case AUDIO_COMMAND_PLAY:
+    mixer_play(cmd->channel, cmd->waveform);
+    break;
+
+  case AUDIO_COMMAND_STOP:
+    mixer_stop(cmd->channel);
+    break;
+
+  case AUDIO_COMMAND_SET:
+    mixer_set(cmd->channel, cmd->set.param, cmd->set.value);
+    break;
+
+  case AUDIO_COMMAND_MASTER:
+    mixer_set_master(cmd->master);
+    break;
   }
 }
 
 /**
-  Generates a raylib sound with the given parameters.
+  Drains the command queue. Only called by the audio callback.
 */
-static Sound generate_sound(waveform_params_t params) {
-  int total_samples = params.duration * SAMPLE_RATE;
-  short* buffer = malloc(total_samples * sizeof(short));
-  generate_waveform(buffer, total_samples, params);
+static void audio_drain_commands(void) {
+  size_t head = atomic_load_explicit(&audio_queue_head, memory_order_relaxed);
+  size_t tail = atomic_load_explicit(&audio_queue_tail, memory_order_acquire);
 
-  // clang-format off
-  Sound sound = LoadSoundFromWave((Wave){
-    .frameCount = total_samples,
-    .sampleRate = SAMPLE_RATE,
-    .sampleSize = 16,
-    .channels = 1,
-    .data = buffer
-  });
-  // clang-format on
+  while (head != tail) {
+    audio_apply_command(&audio_queue[head & (AUDIO_QUEUE_CAPACITY - 1)]);
+    head++;
+  }
 
+  atomic_store_explicit(&audio_queue_head, head, memory_order_release);
+}
 
-  free(buffer);
-  return sound;
+/**
+  Picks up every queued command, then mixes the next buffer of samples.
+*/
+static void audio_callback(void* buffer, unsigned int frames) {
+  double start = system_clock();
+  audio_drain_commands();
+  mixer_render(buffer, frames);
+  bench_audio(system_clock() - start);
+  trace_end("audio_mix", start);
 }
 
 void audio_init(void) {
+  audio_enabled = true;
+  mixer_init();
+  if (system_headless())
+    return;
+
   InitAudioDevice();
 
-  for (int i = 0; i < sizeof(channels) / sizeof(Sound); i++)
-    channels[i] = generate_sound((waveform_params_t){
-      .semitone = 3, .type = i + 1, .volume = 1, .duration = 3
-    });
+  SetAudioStreamBufferSizeDefault(AUDIO_BUFFER_FRAMES);
+  audio_stream = LoadAudioStream(SAMPLE_RATE, 16, 2);
+  SetAudioStreamCallback(audio_stream, audio_callback);
+  PlayAudioStream(audio_stream);
 }
 
 void audio_blip(int waveform_id, int semitone, float volume, float duration) {
-  int channel = waveform_id - 1;
+  double trace_start = trace_begin();
 
   // clang-format off
-  UnloadSound(channels[channel]);
-  channels[channel] = generate_sound((waveform_params_t){
+  audio_play(waveform_id, (waveform_params_t){
     .type = waveform_id,
     .semitone = semitone,
     .volume = volume,
@@ -101,19 +123,80 @@ void audio_blip(int waveform_id, int semitone, float volume, float duration) {
   });
   // clang-format on
 
-  PlaySound(channels[channel]);
+  trace_end("audio_blip", trace_start);
+}
+
+void audio_play(int channel, waveform_params_t params) {
+  if (channel < 1 || channel > AUDIO_CHANNELS)
+    return;
+
+  double trace_start = trace_begin();
+  audio_push_command((audio_command_t){
+    .id = AUDIO_COMMAND_PLAY, .channel = channel - 1, .waveform = params
+  });
+  trace_end("audio_play", trace_start);
+}
+
+void audio_stop(int channel) {
+  if (channel < 1 || channel > AUDIO_CHANNELS)
+    return;
+
+  audio_push_command(
+    (audio_command_t){.id = AUDIO_COMMAND_STOP, .channel = channel - 1}
+  );
+}
+
+void audio_set(int channel, audio_param_t param, float value) {
+  if (channel < 1 || channel > AUDIO_CHANNELS)
+    return;
+
+  // clang-format off
+  audio_push_command((audio_command_t){
+    .id = AUDIO_COMMAND_SET,
+    .channel = channel - 1,
+    .set = {.param = param, .value = value}
+  });
+  // clang-format on
+}
+
+void audio_master(float volume) {
+  audio_push_command(
+    (audio_command_t){.id = AUDIO_COMMAND_MASTER, .master = volume}
+  );
+}
+
+void audio_update(double seconds) {
+  if (!audio_enabled)
+    return;
+
+  double trace_start = trace_begin();
+  unsigned int frames = (unsigned int)(seconds * SAMPLE_RATE);
+  audio_drain_commands();
+
+  while (frames > 0) {
+    unsigned int block = frames < AUDIO_BUFFER_FRAMES ? frames
+                                                      : AUDIO_BUFFER_FRAMES;
+    mixer_render(audio_scratch, block);
+    frames -= block;
+  }
+
+  trace_end("audio_mix", trace_start);
+}
+
+const size_t audio_dropped(void) {
+  return atomic_load_explicit(&audio_queue_dropped, memory_order_relaxed);
 }
 
 void audio_free(void) {
-  for (int i = 0; i < sizeof(channels) / sizeof(Sound); i++) {
-    if (IsSoundValid(channels[i])) {
-      // Unload the sound and assign it to NULL to ensure this resource is
-      // never freed again.
-      UnloadSound(channels[i]);
-      channels[i] = (Sound){0};
-    }
+  if (IsAudioStreamValid(audio_stream)) {
+    // Unload the stream and zero it out to ensure this resource is never
+    // freed again.
+    StopAudioStream(audio_stream);
+    UnloadAudioStream(audio_stream);
+    audio_stream = (AudioStream){0};
   }
 
-  if (IsAudioDeviceReady())
+  if (!system_headless() && IsAudioDeviceReady())
     CloseAudioDevice();
+  audio_enabled = false;
 }
@@ -12,17 +12,64 @@
 #include "system.h"
 #include <math.h>
 #include <raylib.h>
+#include <stdatomic.h>
 #include <stdio.h>
 #include <stdlib.h>
 
 #define SAMPLE_RATE 44100
 #define ROOT_NOTE_FREQUENCY 440.0f
 
+// The first four channels play their own waveform by default. The rest cycle
+// through the same four waveforms unless told otherwise.
+#define AUDIO_CHANNELS 64
+#define AUDIO_BUFFER_FRAMES 512
+
+// The capacity of the audio command queue. Must be a power of two.
+#define AUDIO_QUEUE_CAPACITY 256
+
 typedef struct {
   int type, semitone;
-  float duration, volume;
+  float duration, volume, pan;
 } waveform_params_t;
 
+/**
+  The kinds of commands the game thread can send to the audio engine.
+*/
+typedef enum {
+  AUDIO_COMMAND_PLAY,
+  AUDIO_COMMAND_STOP,
+  AUDIO_COMMAND_SET,
+  AUDIO_COMMAND_MASTER
+} audio_command_id_t;
+
+/**
+  The parameters of a playing channel that can be changed with `audio_set()`.
+*/
+typedef enum {
+  AUDIO_PARAM_SEMITONE,
+  AUDIO_PARAM_VOLUME,
+  AUDIO_PARAM_PAN
+} audio_param_t;
+
+/**
+  A single command sent from the game thread to the audio callback.
+*/
+typedef struct {
+  audio_command_id_t id;
+  int channel;
+
+  union {
+    waveform_params_t waveform;
+
+    struct {
+      audio_param_t param;
+      float value;
+    } set;
+
+    float master;
+  };
+} audio_command_t;
+
 /**
   Initializes audio and all data related to it.
 
@@ -32,9 +79,52 @@ void audio_init(void);
 
 /**
   Plays a given waveform with the given semitone, volume, and duration.
+
+  This function never blocks. The sound is queued and starts playing the next
+  time the audio device asks for samples.
 */
 void audio_blip(int waveform_id, int semitone, float volume, float duration);
 
+/**
+  Plays a sound on the given channel using the given parameters, replacing
+  whatever was playing on that channel. Channels are numbered from 1 to
+  `AUDIO_CHANNELS`.
+
+  Like `audio_blip()`, this function never blocks.
+*/
+void audio_play(int channel, waveform_params_t params);
+
+/**
+  Stops whatever is playing on the given channel.
+*/
+void audio_stop(int channel);
+
+/**
+  Changes a parameter of the sound currently playing on the given channel
+  without restarting it.
+*/
+void audio_set(int channel, audio_param_t param, float value);
+
+/**
+  Sets the volume of everything played, after every channel is mixed together.
+  1.0 is the default, and the volume is clamped between 0.0 and 4.0.
+*/
+void audio_master(float volume);
+
+/**
+  Processes queued commands and mixes the given number of seconds of audio
+  into a scratch buffer that's thrown away. Used to keep the audio engine
+  running when there's no audio device to pull samples, like when running
+  headless.
+*/
+void audio_update(double seconds);
+
+/**
+  Returns how many audio commands were dropped because the command queue was
+  full.
+*/
+const size_t audio_dropped(void);
+
 /**
   Frees all data related to audio.
 */
@@ -0,0 +1,138 @@
+/**
+  src/api/bench.c
+
+  Written by DoelJavid for V-GAME.
+
+  https://github.com/DoelJavid/v-game
+*/
+
+#include "bench.h"
+
+static const char* const bench_phase_names[BENCH_PHASES] = {
+  "lua", "commands", "present", "audio", "idle"
+};
+
+static INSTANCE_LOCAL bool bench_running = false;
+static INSTANCE_LOCAL size_t bench_frames = 0;
+static INSTANCE_LOCAL stats_t bench_stats[BENCH_PHASES];
+static INSTANCE_LOCAL stats_t bench_total;
+
+static INSTANCE_LOCAL bench_phase_t bench_current = BENCH_PHASE_LUA;
+static INSTANCE_LOCAL double bench_phase_start = 0.0;
+static INSTANCE_LOCAL double bench_frame_times[BENCH_PHASES] = {0};
+
+// The audio thread adds to this in nanoseconds, and the game thread takes it
+// at the end of each frame.
+static atomic_uint_least64_t bench_audio_nanoseconds = 0;
+
+void bench_init(size_t frames) {
+  for (int i = 0; i < BENCH_PHASES; i++)
+    if (!stats_init(&bench_stats[i], frames))
+      return;
+
+  if (!stats_init(&bench_total, frames))
+    return;
+
+  bench_running = true;
+  bench_frames = frames;
+  bench_current = BENCH_PHASE_LUA;
+  bench_phase_start = system_clock();
+}
+
+bool bench_active(void) {
+  return bench_running;
+}
+
+void bench_phase(bench_phase_t phase) {
+  if (!bench_running)
+    return;
+
+  double now = system_clock();
+  bench_frame_times[bench_current] += now - bench_phase_start;
+  bench_current = phase;
+  bench_phase_start = now;
+}
+
+void bench_audio(double seconds) {
+  if (!bench_running)
+    return;
+
+  atomic_fetch_add_explicit(
+    &bench_audio_nanoseconds, (uint_least64_t)(seconds * 1e9),
+    memory_order_relaxed
+  );
+}
+
+bool bench_frame(void) {
+  if (!bench_running)
+    return false;
+
+  bench_phase(bench_current);
+  bench_frame_times[BENCH_PHASE_AUDIO] +=
+    atomic_exchange_explicit(
+      &bench_audio_nanoseconds, 0, memory_order_relaxed
+    ) / 1e9;
+
+  double total = 0.0;
+  for (int i = 0; i < BENCH_PHASES; i++) {
+    stats_push(&bench_stats[i], bench_frame_times[i]);
+    total += bench_frame_times[i];
+    bench_frame_times[i] = 0.0;
+  }
+  stats_push(&bench_total, total);
+
+  return bench_total.count >= bench_frames;
+}
+
+/**
+  Prints a row of the human-readable table.
+*/
+static void print_row(const char* name, stats_summary_t summary) {
+  SYSTEM_LOG(
+    "%-10s %9.3f %9.3f %9.3f %9.3f %9.3f", name, summary.mean * 1000,
+    summary.p50 * 1000, summary.p95 * 1000, summary.p99 * 1000,
+    summary.max * 1000
+  );
+}
+
+/**
+  Prints a phase as a JSON object member.
+*/
+static void print_json(const char* name, stats_summary_t summary, bool last) {
+  printf(
+    "\"%s\":{\"mean\":%.6f,\"p50\":%.6f,\"p95\":%.6f,\"p99\":%.6f,"
+    "\"max\":%.6f}%s",
+    name, summary.mean * 1000, summary.p50 * 1000, summary.p95 * 1000,
+    summary.p99 * 1000, summary.max * 1000, last ? "" : ","
+  );
+}
+
+void bench_free(void) {
+  if (!bench_running)
+    return;
+  bench_running = false;
+
+  stats_summary_t phases[BENCH_PHASES];
+  for (int i = 0; i < BENCH_PHASES; i++)
+    phases[i] = stats_summarize(&bench_stats[i]);
+  stats_summary_t total = stats_summarize(&bench_total);
+
+  SYSTEM_LOG("Benchmark of %zu frames (milliseconds):", total.count);
+  SYSTEM_LOG(
+    "%-10s %9s %9s %9s %9s %9s", "phase", "mean", "p50", "p95", "p99", "max"
+  );
+  for (int i = 0; i < BENCH_PHASES; i++)
+    print_row(bench_phase_names[i], phases[i]);
+  print_row("frame", total);
+
+  printf("{\"frames\":%zu,\"unit\":\"ms\",\"phases\":{", total.count);
+  for (int i = 0; i < BENCH_PHASES; i++)
+    print_json(bench_phase_names[i], phases[i], false);
+  print_json("frame", total, true);
+  printf("}}\n");
+  fflush(stdout);
+
+  for (int i = 0; i < BENCH_PHASES; i++)
+    stats_free(&bench_stats[i]);
+  stats_free(&bench_total);
+}
@@ -0,0 +1,61 @@
+/**
+  src/api/bench.h
+
+  Written by DoelJavid for V-GAME.
+
+  https://github.com/DoelJavid/v-game
+*/
+
+#ifndef API_BENCH_H
+#define API_BENCH_H
+
+#include "stats.h"
+#include "system.h"
+#include <stdatomic.h>
+#include <stdint.h>
+
+/**
+  The phases a frame is broken down into while benchmarking.
+*/
+typedef enum {
+  BENCH_PHASE_LUA,      // Running the game's Lua code.
+  BENCH_PHASE_COMMANDS, // Processing graphics commands in `graphics_draw()`.
+  BENCH_PHASE_PRESENT,  // Presenting the frame in `system_interrupt()`.
+  BENCH_PHASE_AUDIO,    // Mixing audio, on whichever thread that happens.
+  BENCH_PHASE_IDLE,     // Deferred work like garbage collection.
+  BENCH_PHASES
+} bench_phase_t;
+
+/**
+  Starts benchmarking the given number of frames.
+*/
+void bench_init(size_t frames);
+
+/**
+  Returns true while a benchmark is running.
+*/
+bool bench_active(void);
+
+/**
+  Ends the phase the game thread is currently in and starts the given one.
+*/
+void bench_phase(bench_phase_t phase);
+
+/**
+  Adds time spent mixing audio on another thread to the current frame. Safe to
+  call from the audio thread.
+*/
+void bench_audio(double seconds);
+
+/**
+  Ends the current frame. Returns true once every frame has been measured.
+*/
+bool bench_frame(void);
+
+/**
+  Prints the per-phase frame times as a human-readable table followed by a
+  single line of JSON, then stops benchmarking.
+*/
+void bench_free(void);
+
+#endif
@@ -0,0 +1,194 @@
+/**
+  src/api/cart.c
+
+  Written by DoelJavid for V-GAME.
+
+  https://github.com/DoelJavid/v-game
+*/
+
+#include "cart.h"
+
+static const char cart_magic[4] = {'V', 'C', 'R', 'T'};
+
+static INSTANCE_LOCAL const unsigned char* cart_data = NULL;
+static INSTANCE_LOCAL size_t cart_size = 0;
+static INSTANCE_LOCAL const cart_entry_t* cart_index = NULL;
+static INSTANCE_LOCAL size_t cart_count = 0;
+
+/**
+  Returns the given offset rounded up to `CART_ALIGNMENT`.
+*/
+static uint64_t align_offset(uint64_t offset) {
+  return (offset + CART_ALIGNMENT - 1) & ~(uint64_t)(CART_ALIGNMENT - 1);
+}
+
+/**
+  Checks that the mapped cartridge is well formed, so nothing read from it
+  later can point outside of it.
+*/
+static bool validate_cart(void) {
+  if (cart_size < sizeof(cart_header_t))
+    return false;
+
+  const cart_header_t* header = (const cart_header_t*)cart_data;
+  if (memcmp(header->magic, cart_magic, 4) != 0 ||
+      header->version != CART_VERSION || header->size != cart_size ||
+      header->index_offset % CART_ALIGNMENT != 0 ||
+      header->index_offset > cart_size ||
+      header->count > (cart_size - header->index_offset) / sizeof(cart_entry_t))
+    return false;
+
+  cart_index = (const cart_entry_t*)&cart_data[header->index_offset];
+  cart_count = header->count;
+
+  for (size_t i = 0; i < cart_count; i++) {
+    const cart_entry_t* entry = &cart_index[i];
+    if (memchr(entry->name, '\0', CART_NAME_SIZE) == NULL ||
+        entry->offset > cart_size || entry->length > cart_size - entry->offset)
+      return false;
+
+    // Lookups rely on the index being sorted.
+    if (i > 0 && strcmp(cart_index[i - 1].name, entry->name) >= 0)
+      return false;
+  }
+
+  return true;
+}
+
+bool cart_open(const char* path) {
+  cart_close();
+
+  cart_data = system_map_file(path, &cart_size);
+  if (!cart_data) {
+    SYSTEM_ERROR_LOG("Failed to open cartridge \"%s\"!", path);
+    return false;
+  }
+
+  if (!validate_cart()) {
+    SYSTEM_ERROR_LOG("\"%s\" is not a valid cartridge!", path);
+    cart_close();
+    return false;
+  }
+
+  return true;
+}
+
+bool cart_loaded(void) {
+  return cart_data != NULL;
+}
+
+/**
+  Compares a name against an index entry for `bsearch()`.
+*/
+static int compare_entry(const void* name, const void* entry) {
+  return strcmp(name, ((const cart_entry_t*)entry)->name);
+}
+
+bool cart_find(const char* name, cart_blob_t* blob) {
+  if (!cart_data)
+    return false;
+
+  const cart_entry_t* entry = bsearch(
+    name, cart_index, cart_count, sizeof(cart_entry_t), compare_entry
+  );
+  if (!entry)
+    return false;
+
+  blob->name = entry->name;
+  blob->type = entry->type;
+  blob->data = &cart_data[entry->offset];
+  blob->length = entry->length;
+  return true;
+}
+
+/**
+  Compares two blobs by name for `qsort()`.
+*/
+static int compare_blob(const void* a, const void* b) {
+  return strcmp(((const cart_blob_t*)a)->name, ((const cart_blob_t*)b)->name);
+}
+
+/**
+  Writes the given data followed by zeroes up to `padded_length` bytes.
+*/
+static bool write_padded(
+  FILE* file, const void* data, size_t length, size_t padded_length
+) {
+  static const char padding[CART_ALIGNMENT] = {0};
+  if (length > 0 && fwrite(data, 1, length, file) != length)
+    return false;
+
+  size_t remaining = padded_length - length;
+  return fwrite(padding, 1, remaining, file) == remaining;
+}
+
+bool cart_write(const char* path, const cart_blob_t* blobs, size_t count) {
+  cart_blob_t* sorted = malloc((count ? count : 1) * sizeof(cart_blob_t));
+  cart_entry_t* index = calloc(count ? count : 1, sizeof(cart_entry_t));
+  if (!sorted || !index) {
+    free(sorted);
+    free(index);
+    return false;
+  }
+
+  memcpy(sorted, blobs, count * sizeof(cart_blob_t));
+  qsort(sorted, count, sizeof(cart_blob_t), compare_blob);
+
+  uint64_t index_offset = align_offset(sizeof(cart_header_t));
+  uint64_t offset = align_offset(index_offset + count * sizeof(cart_entry_t));
+  for (size_t i = 0; i < count; i++) {
+    if (strlen(sorted[i].name) >= CART_NAME_SIZE) {
+      SYSTEM_ERROR_LOG("Blob name \"%s\" is too long!", sorted[i].name);
+      free(sorted);
+      free(index);
+      return false;
+    }
+
+    strcpy(index[i].name, sorted[i].name);
+    index[i].type = sorted[i].type;
+    index[i].offset = offset;
+    index[i].length = sorted[i].length;
+    offset = align_offset(offset + sorted[i].length);
+  }
+
+  // clang-format off
+  cart_header_t header = {
+    .magic = {'V', 'C', 'R', 'T'},
+    .version = CART_VERSION,
+    .count = count,
+    .alignment = CART_ALIGNMENT,
+    .index_offset = index_offset,
+    .size = offset
+  };
+  // clang-format on
+
+  uint64_t data_offset = count ? index[0].offset : offset;
+  FILE* file = fopen(path, "wb");
+  bool written =
+    file && write_padded(file, &header, sizeof(header), index_offset) &&
+    write_padded(
+      file, index, count * sizeof(cart_entry_t), data_offset - index_offset
+    );
+
+  for (size_t i = 0; written && i < count; i++)
+    written = write_padded(
+      file, sorted[i].data, sorted[i].length, align_offset(sorted[i].length)
+    );
+
+  if (file && fclose(file) != 0)
+    written = false;
+  free(sorted);
+  free(index);
+
+  if (!written)
+    SYSTEM_ERROR_LOG("Failed to write cartridge \"%s\"!", path);
+  return written;
+}
+
+void cart_close(void) {
+  system_unmap_file(cart_data, cart_size);
+  cart_data = NULL;
+  cart_size = 0;
+  cart_index = NULL;
+  cart_count = 0;
+}
@@ -0,0 +1,101 @@
+/**
+  src/api/cart.h
+
+  Written by DoelJavid for V-GAME.
+
+  https://github.com/DoelJavid/v-game
+*/
+
+#ifndef API_CART_H
+#define API_CART_H
+
+#include "system.h"
+#include <stdint.h>
+#include <string.h>
+
+#define CART_VERSION 1
+
+// The extension given to cartridge files.
+#define CART_EXTENSION ".vcart"
+
+// Every blob starts at a multiple of this many bytes from the start of the
+// file, so blobs can be used in place once the file is mapped.
+#define CART_ALIGNMENT 16
+
+// The longest blob name, including the null terminator.
+#define CART_NAME_SIZE 44
+
+/**
+  What a blob in a cartridge holds.
+*/
+typedef enum {
+  CART_BLOB_DATA,
+  CART_BLOB_SCRIPT,
+  CART_BLOB_BYTECODE,
+  CART_BLOB_SHAPES,
+  CART_BLOB_SOUNDS
+} cart_blob_type_t;
+
+/**
+  The start of every cartridge. It's followed by `count` index entries sorted
+  by name, then the blobs themselves.
+*/
+typedef struct {
+  char magic[4];
+  uint32_t version;
+  uint32_t count;
+  uint32_t alignment;
+  uint64_t index_offset;
+  uint64_t size;
+} cart_header_t;
+
+/**
+  An entry in a cartridge's index.
+*/
+typedef struct {
+  char name[CART_NAME_SIZE];
+  uint32_t type;
+  uint64_t offset;
+  uint64_t length;
+} cart_entry_t;
+
+/**
+  A blob within a cartridge. When reading, `data` points straight into the
+  mapped cartridge and stays valid until `cart_close()`.
+*/
+typedef struct {
+  const char* name;
+  cart_blob_type_t type;
+  const void* data;
+  size_t length;
+} cart_blob_t;
+
+/**
+  Maps the cartridge at the given path and checks that it's well formed.
+  Returns false if it can't be opened or is corrupt.
+*/
+bool cart_open(const char* path);
+
+/**
+  Returns true if a cartridge is open.
+*/
+bool cart_loaded(void);
+
+/**
+  Looks up the blob with the given name in the open cartridge and stores it in
+  `blob`. Returns false if there's no such blob.
+*/
+bool cart_find(const char* name, cart_blob_t* blob);
+
+/**
+  Writes a cartridge holding the given blobs to the given path. Returns false
+  if it can't be written.
+*/
+bool cart_write(const char* path, const cart_blob_t* blobs, size_t count);
+
+/**
+  Unmaps the open cartridge.
+*/
+void cart_close(void);
+
+#endif
@@ -7,10 +7,12 @@
 */
 
 #include "graphics.h"
+#include "bench.h"
+#include "trace.h"
 
-static RenderTexture2D* graphics_framebuffer;
-static size_t graphics_command_index = 0;
-static draw_command_t graphics_commands[MAX_GRAPHICS_COMMANDS] = {0};
+static INSTANCE_LOCAL RenderTexture2D* graphics_framebuffer;
+static INSTANCE_LOCAL size_t graphics_command_index = 0;
+static INSTANCE_LOCAL draw_command_t graphics_commands[MAX_GRAPHICS_COMMANDS] = {0};
 
 void graphics_init(RenderTexture2D* framebuffer) {
   assert(
@@ -18,8 +20,11 @@ void graphics_init(RenderTexture2D* framebuffer) {
     "`graphics_init()` expected framebuffer! Passed NULL!"
   );
 
-  *framebuffer = LoadRenderTexture(GetRenderWidth(), GetRenderHeight());
   graphics_framebuffer = framebuffer;
+  if (system_headless())
+    return;
+
+  *framebuffer = LoadRenderTexture(GetRenderWidth(), GetRenderHeight());
 }
 
 void graphics_push_command(draw_command_t cmd) {
@@ -44,19 +49,28 @@ void graphics_move(float x, float y) {
   graphics_push_command((draw_command_t){3, x, y});
 }
 
-void graphics_draw(void) {
-  static float turtle_x, turtle_y = 0.0f;
-  static Color current_color;
+bool graphics_draw(void) {
+  static INSTANCE_LOCAL float turtle_x, turtle_y = 0.0f;
+  static INSTANCE_LOCAL Color current_color;
+  bench_phase(BENCH_PHASE_COMMANDS);
+  trace_lua_leave();
+  double trace_start = trace_begin();
+
+  // When the frame pacer is skipping this frame, the commands still run so
+  // the color and position carry over, but nothing is drawn.
+  const bool skip = system_frame_skipped() || system_headless();
 
   // Begin drawing.
-  BeginTextureMode(*graphics_framebuffer);
+  if (!skip)
+    BeginTextureMode(*graphics_framebuffer);
 
   for (int i = 0; i < graphics_command_index; i++) {
     draw_command_t current_command = graphics_commands[i];
 
     switch (current_command.id) {
     case 0: // Clear Background (graphics.clear())
-      ClearBackground(BLACK);
+      if (!skip)
+        ClearBackground(BLACK);
       break;
 
     case 1: // Set Color (graphics.color())
@@ -90,18 +104,19 @@ void graphics_draw(void) {
 
     case 2: // Draw To Point (graphics.plot())
       // clang-format off
-      DrawLineEx(
-        (Vector2){
-          turtle_x * GetRenderWidth(),
-          turtle_y * GetRenderHeight()
-        },
-        (Vector2){
-          current_command.x * GetRenderWidth(),
-          current_command.y * GetRenderHeight()
-        },
-        3.0f,
-        current_color
-      );
+      if (!skip)
+        DrawLineEx(
+          (Vector2){
+            turtle_x * GetRenderWidth(),
+            turtle_y * GetRenderHeight()
+          },
+          (Vector2){
+            current_command.x * GetRenderWidth(),
+            current_command.y * GetRenderHeight()
+          },
+          3.0f,
+          current_color
+        );
       // clang-format on
 
     case 3: // Move To Point (graphics.move())
@@ -117,8 +132,10 @@ void graphics_draw(void) {
   graphics_command_index = 0;
 
   // End drawing and interrupt to draw framebuffer.
-  EndTextureMode();
-  system_interrupt();
+  if (!skip)
+    EndTextureMode();
+  trace_end("graphics_draw", trace_start);
+  return system_interrupt();
 }
 
 const size_t graphics_count(void) { return graphics_command_index; }
@@ -71,9 +71,10 @@ void graphics_plot(float x, float y);
 void graphics_move(float x, float y);
 
 /**
-  Draws all the currently used commands.
+  Draws all the currently used commands, then interrupts. Returns false once
+  the runtime should stop.
 */
-void graphics_draw(void);
+bool graphics_draw(void);
 
 /**
   Gets the total amount of commands stored within graphics memory.
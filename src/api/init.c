@@ -8,14 +8,36 @@
 
 #include "init.h"
 
-void api_init(sys_args_t args) {
+int api_init(sys_args_t args) {
+  logger_init(args.log_level);
   system_init(args);
   graphics_init(system_get_framebuffer());
   audio_init();
+
+  if (args.latency_probe)
+    latency_init();
+  if (args.bench_frames > 0)
+    bench_init(args.bench_frames);
+  if (args.trace_path)
+    trace_init(args.trace_path);
+
+  return replay_init(args.record_input, args.replay_input);
 }
 
 void api_free(void) {
+  // Saves are shared by every game in the process, so they're only finished
+  // once all of them have stopped.
+  storage_free();
+
+  // Stopping the writer first keeps the reports printed during shutdown in
+  // order with everything logged before them.
+  logger_free();
+  // The audio thread records trace events, so it's stopped before tracing.
   audio_free();
+  trace_free();
+  bench_free();
+  latency_free();
+  replay_free();
   graphics_free();
   system_free();
 }
@@ -13,11 +13,16 @@
 #include "graphics.h"
 #include "audio.h"
 #include "input.h"
+#include "bench.h"
+#include "latency.h"
+#include "replay.h"
+#include "storage.h"
+#include "trace.h"
 
 /**
-  Initializes all APIs at once to be used.
+  Initializes all APIs at once to be used. Returns 0 on success.
 */
-void api_init(sys_args_t args);
+int api_init(sys_args_t args);
 
 /**
   Stops all apis.
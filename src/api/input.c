@@ -7,6 +7,8 @@
 */
 
 #include "input.h"
+#include "latency.h"
+#include "replay.h"
 
 // clang-format off
 static const int keyboard_input_map[] = {
@@ -45,18 +47,83 @@ static const int gamepad_input_map[] = {
 };
 // clang-format on
 
+// Button states as of the latest and the previous poll, one mask per
+// controller.
+static INSTANCE_LOCAL input_mask_t input_current[INPUT_CONTROLLERS] = {0};
+static INSTANCE_LOCAL input_mask_t input_previous[INPUT_CONTROLLERS] = {0};
+
+/**
+  Returns the buttons held down on the given gamepad.
+*/
+static input_mask_t poll_gamepad(int gamepad) {
+  input_mask_t mask = 0;
+  if (!IsGamepadAvailable(gamepad))
+    return mask;
+
+  for (int i = 0; i < INPUT_BUTTONS; i++)
+    if (IsGamepadButtonDown(gamepad, gamepad_input_map[i]))
+      mask |= 1 << i;
+  return mask;
+}
+
+/**
+  Returns the buttons held down on the keyboard.
+*/
+static input_mask_t poll_keyboard(void) {
+  input_mask_t mask = 0;
+  for (int i = 0; i < INPUT_BUTTONS; i++)
+    if (IsKeyDown(keyboard_input_map[i]))
+      mask |= 1 << i;
+  return mask;
+}
+
+void input_poll(void) {
+  // Without a window there's nothing to read from, but replays still work.
+  const bool headless = system_headless();
+
+  for (int i = 0; i < INPUT_CONTROLLERS; i++) {
+    input_previous[i] = input_current[i];
+    input_current[i] = headless ? 0 : poll_gamepad(i);
+  }
+
+  if (!headless)
+    input_current[0] |= poll_keyboard();
+  replay_frame(input_current);
+}
+
+void input_latch(void) {
+  if (!system_headless())
+    PollInputEvents();
+  input_poll();
+
+  bool pressed = false;
+  for (int i = 0; i < INPUT_CONTROLLERS; i++)
+    if (input_current[i] & ~input_previous[i])
+      pressed = true;
+
+  latency_input(pressed, system_clock());
+}
+
+input_mask_t input_mask(int controller_id) {
+  if (controller_id < 1 || controller_id > INPUT_CONTROLLERS)
+    return 0;
+  return input_current[controller_id - 1];
+}
+
 bool input_pressed(int button_id, int controller_id) {
-  if (button_id < 0 || button_id > 12)
+  if (button_id < 0 || button_id >= INPUT_BUTTONS)
     return false;
 
-  return IsGamepadButtonDown(0, gamepad_input_map[button_id]) ||
-         IsKeyDown(keyboard_input_map[button_id]);
+  return input_mask(controller_id) >> button_id & 1;
 }
 
 bool input_tapped(int button_id, int controller_id) {
-  if (button_id < 0 || button_id > 12)
+  if (button_id < 0 || button_id >= INPUT_BUTTONS)
+    return false;
+  if (controller_id < 1 || controller_id > INPUT_CONTROLLERS)
     return false;
 
-  return IsGamepadButtonPressed(0, gamepad_input_map[button_id]) ||
-         IsKeyPressed(keyboard_input_map[button_id]);
+  input_mask_t tapped =
+    input_current[controller_id - 1] & ~input_previous[controller_id - 1];
+  return tapped >> button_id & 1;
 }
@@ -10,6 +10,39 @@
 #define API_INPUT_H
 
 #include <raylib.h>
+#include <stdint.h>
+
+#define INPUT_BUTTONS 12
+#define INPUT_CONTROLLERS 4
+
+/**
+  The state of every button on a controller packed into a single integer. Bit
+  `n` is set when the button with input code `n + 1` is held down.
+*/
+typedef uint16_t input_mask_t;
+
+/**
+  Samples every button of every connected controller and stores the result as
+  the current input state. The previous state is kept around so taps can be
+  detected. Called once per interrupt.
+
+  Controller one reads from both the keyboard and the first gamepad. Every
+  other controller reads from the gamepad with the same index.
+*/
+void input_poll(void);
+
+/**
+  Polls the operating system for new input events, then samples them with
+  `input_poll()`. This is the last thing an interrupt does before control
+  returns to Lua, so the game always sees the freshest input possible.
+*/
+void input_latch(void);
+
+/**
+  Returns the buttons held down on the given controller as of the last call to
+  `input_poll()`. Returns 0 if the controller index is out of range.
+*/
+input_mask_t input_mask(int controller_id);
 
 /**
   Returns true if the given button index is pressed and false if otherwise.
@@ -48,4 +81,3 @@ bool input_pressed(int button_id, int controller_id);
 bool input_tapped(int button_id, int controller_id);
 
 #endif
-
@@ -86,7 +86,8 @@ void intro_play(void) {
       color = color % 8 + 1;
     }
 
-    graphics_draw();
+    if (!graphics_draw())
+      return;
   }
 }
 
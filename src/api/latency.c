@@ -0,0 +1,81 @@
+/**
+  src/api/latency.c
+
+  Written by DoelJavid for V-GAME.
+
+  https://github.com/DoelJavid/v-game
+*/
+
+#include "latency.h"
+
+static INSTANCE_LOCAL bool latency_enabled = false;
+static INSTANCE_LOCAL stats_t latency_samples;
+static INSTANCE_LOCAL stats_t latency_windows;
+
+// The time the oldest press the game hasn't presented yet was sampled, or a
+// negative number if there's no such press.
+static INSTANCE_LOCAL double latency_pending = -1.0;
+static INSTANCE_LOCAL double latency_last_sample = -1.0;
+
+void latency_init(void) {
+  if (!stats_init(&latency_samples, LATENCY_SAMPLES) ||
+      !stats_init(&latency_windows, LATENCY_SAMPLES)) {
+    SYSTEM_ERROR_LOG("Failed to start the latency probe!");
+    stats_free(&latency_samples);
+    return;
+  }
+
+  latency_enabled = true;
+}
+
+void latency_input(bool pressed, double time) {
+  if (!latency_enabled)
+    return;
+
+  // The press happened somewhere between the previous sample and this one.
+  // Keep track of how wide that window is so the report can show how much
+  // latency happens before the runtime even sees the press.
+  if (pressed && latency_last_sample >= 0.0)
+    stats_push(&latency_windows, time - latency_last_sample);
+
+  if (pressed && latency_pending < 0.0)
+    latency_pending = time;
+
+  latency_last_sample = time;
+}
+
+void latency_present(double time) {
+  if (!latency_enabled || latency_pending < 0.0)
+    return;
+
+  // Input is sampled right before control returns to Lua, so the frame being
+  // presented is the first one drawn after the game saw the press.
+  stats_push(&latency_samples, time - latency_pending);
+  latency_pending = -1.0;
+}
+
+void latency_free(void) {
+  if (!latency_enabled)
+    return;
+
+  stats_summary_t latency = stats_summarize(&latency_samples);
+  stats_summary_t window = stats_summarize(&latency_windows);
+
+  SYSTEM_LOG("Input-to-present latency over %zu presses:", latency.count);
+  if (latency.count > 0) {
+    SYSTEM_LOG(
+      "  sample to present: min %.2fms, p50 %.2fms, p95 %.2fms, p99 %.2fms, "
+      "max %.2fms",
+      latency.min * 1000, latency.p50 * 1000, latency.p95 * 1000,
+      latency.p99 * 1000, latency.max * 1000
+    );
+    SYSTEM_LOG(
+      "  press to sample: up to %.2fms (mean sampling window)",
+      window.mean * 1000
+    );
+  }
+
+  stats_free(&latency_samples);
+  stats_free(&latency_windows);
+  latency_enabled = false;
+}
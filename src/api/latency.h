@@ -0,0 +1,41 @@
+/**
+  src/api/latency.h
+
+  Written by DoelJavid for V-GAME.
+
+  https://github.com/DoelJavid/v-game
+*/
+
+#ifndef API_LATENCY_H
+#define API_LATENCY_H
+
+#include "stats.h"
+#include "system.h"
+
+// How many latency samples the probe keeps for its report.
+#define LATENCY_SAMPLES 4096
+
+/**
+  Starts the input latency probe. While the probe is running, every button
+  press is timestamped when it's sampled, and the latency is recorded once the
+  first frame presented after the game saw the press has been swapped.
+*/
+void latency_init(void);
+
+/**
+  Tells the probe input was just sampled at the given time. `pressed` should be
+  true if any button went down since the previous sample.
+*/
+void latency_input(bool pressed, double time);
+
+/**
+  Tells the probe a frame finished presenting at the given time.
+*/
+void latency_present(double time);
+
+/**
+  Prints the latency distribution to the console and stops the probe.
+*/
+void latency_free(void);
+
+#endif
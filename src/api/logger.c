@@ -0,0 +1,380 @@
+/**
+  src/api/logger.c
+
+  Written by DoelJavid for V-GAME.
+
+  https://github.com/DoelJavid/v-game
+*/
+
+#include "logger.h"
+#include "system.h"
+#include <threads.h>
+
+/**
+  A queued message. `sequence` tells producers and the writer thread whose turn
+  it is to use the slot, so messages can be queued from any thread without a
+  lock.
+*/
+typedef struct {
+  atomic_size_t sequence;
+  logger_level_t level;
+  double time;
+  size_t length;
+  char text[LOGGER_MESSAGE_SIZE];
+  // Messages too long for `text` are copied here instead.
+  char* heap;
+} logger_entry_t;
+
+static logger_entry_t logger_queue[LOGGER_QUEUE_CAPACITY];
+static _Alignas(64) atomic_size_t logger_head = 0;
+static _Alignas(64) atomic_size_t logger_tail = 0;
+
+static atomic_bool logger_running = false;
+static atomic_bool logger_stopping = false;
+static thrd_t logger_thread;
+static logger_level_t logger_min_level = LOGGER_LEVEL_INFO;
+static double logger_epoch = -1.0;
+
+static atomic_long logger_window = 0;
+static atomic_size_t logger_window_count = 0;
+static atomic_size_t logger_dropped_count = 0;
+static atomic_size_t logger_unreported = 0;
+
+/**
+  Returns the time since `logger_init()` in seconds, or 0 before it's called.
+*/
+static double logger_time(void) {
+  return logger_epoch < 0.0 ? 0.0 : system_clock() - logger_epoch;
+}
+
+/**
+  Writes a single message to stdout.
+*/
+static void logger_print(
+  logger_level_t level, double time, const char* text, size_t length
+) {
+  switch (level) {
+    case LOGGER_LEVEL_INFO:
+      printf("[%9.3f] %.*s\n", time, (int)length, text);
+      break;
+    case LOGGER_LEVEL_WARNING:
+      printf(
+        LOG_FMT_WARNING "[%9.3f] WARNING: %.*s" LOG_FMT_RESET "\n", time,
+        (int)length, text
+      );
+      break;
+    case LOGGER_LEVEL_ERROR:
+      printf(
+        LOG_FMT_ERROR "[%9.3f] ERROR: %.*s" LOG_FMT_RESET "\n", time,
+        (int)length, text
+      );
+      break;
+    case LOGGER_LEVEL_FATAL:
+      printf(
+        LOG_FMT_ERROR "[%9.3f] FATAL ERROR: %.*s" LOG_FMT_RESET "\n", time,
+        (int)length, text
+      );
+      break;
+  }
+}
+
+/**
+  Marks a message as dropped.
+*/
+static void logger_drop(void) {
+  atomic_fetch_add_explicit(&logger_dropped_count, 1, memory_order_relaxed);
+  atomic_fetch_add_explicit(&logger_unreported, 1, memory_order_relaxed);
+}
+
+/**
+  Returns true if a message of the given level fits within this second's rate
+  limit. Errors are never rate limited.
+*/
+static bool logger_allow(logger_level_t level, double time) {
+  if (level >= LOGGER_LEVEL_ERROR)
+    return true;
+
+  long window = (long)time;
+  long current = atomic_load_explicit(&logger_window, memory_order_relaxed);
+  if (window != current &&
+      atomic_compare_exchange_strong(&logger_window, &current, window))
+    atomic_store_explicit(&logger_window_count, 0, memory_order_relaxed);
+
+  return atomic_fetch_add_explicit(
+           &logger_window_count, 1, memory_order_relaxed
+         ) < LOGGER_RATE_LIMIT;
+}
+
+/**
+  Claims the next free slot in the queue and stores its position in `index`.
+  Returns NULL if the queue is full.
+*/
+static logger_entry_t* logger_claim(size_t* index) {
+  size_t tail = atomic_load_explicit(&logger_tail, memory_order_relaxed);
+
+  for (;;) {
+    logger_entry_t* entry = &logger_queue[tail & (LOGGER_QUEUE_CAPACITY - 1)];
+    size_t sequence =
+      atomic_load_explicit(&entry->sequence, memory_order_acquire);
+
+    if (sequence == tail) {
+      if (atomic_compare_exchange_weak_explicit(
+            &logger_tail, &tail, tail + 1, memory_order_relaxed,
+            memory_order_relaxed
+          )) {
+        *index = tail;
+        return entry;
+      }
+    } else if (sequence < tail) {
+      return NULL;
+    } else {
+      tail = atomic_load_explicit(&logger_tail, memory_order_relaxed);
+    }
+  }
+}
+
+/**
+  Hands a filled slot over to the writer thread.
+*/
+static void logger_publish(logger_entry_t* entry, size_t index) {
+  atomic_store_explicit(&entry->sequence, index + 1, memory_order_release);
+}
+
+/**
+  Writes every message that's ready and returns how many were written. Only
+  called from the writer thread.
+*/
+static size_t logger_drain(void) {
+  size_t head = atomic_load_explicit(&logger_head, memory_order_relaxed);
+  size_t written = 0;
+
+  for (;;) {
+    logger_entry_t* entry = &logger_queue[head & (LOGGER_QUEUE_CAPACITY - 1)];
+    if (atomic_load_explicit(&entry->sequence, memory_order_acquire) !=
+        head + 1)
+      break;
+
+    logger_print(
+      entry->level, entry->time, entry->heap ? entry->heap : entry->text,
+      entry->length
+    );
+    free(entry->heap);
+    entry->heap = NULL;
+    atomic_store_explicit(
+      &entry->sequence, head + LOGGER_QUEUE_CAPACITY, memory_order_release
+    );
+    head++;
+    written++;
+  }
+
+  atomic_store_explicit(&logger_head, head, memory_order_release);
+  return written;
+}
+
+/**
+  The writer thread. Sleeps until there's something to write and flushes
+  stdout once per batch rather than once per message.
+*/
+static int logger_main(void* arg) {
+  (void)arg;
+  const struct timespec poll = {
+    .tv_sec = 0, .tv_nsec = (long)(LOGGER_POLL_SECONDS * 1e9)
+  };
+
+  for (;;) {
+    // Checked before draining so messages queued before stopping still get
+    // written.
+    bool stopping = atomic_load(&logger_stopping);
+    size_t written = logger_drain();
+
+    size_t dropped = atomic_exchange(&logger_unreported, 0);
+    if (dropped > 0) {
+      const char* message = "%zu log messages were dropped.";
+      char text[LOGGER_MESSAGE_SIZE];
+      int length = snprintf(text, sizeof(text), message, dropped);
+      logger_print(LOGGER_LEVEL_WARNING, logger_time(), text, length);
+      written++;
+    }
+
+    if (written > 0)
+      fflush(stdout);
+    if (stopping)
+      return 0;
+    if (written == 0)
+      thrd_sleep(&poll, NULL);
+  }
+}
+
+/**
+  Ends a full `LOGGER_MESSAGE_SIZE` buffer with "..." to show it was cut off,
+  and returns its new length.
+*/
+static size_t logger_cut(char* text) {
+  memcpy(&text[LOGGER_MESSAGE_SIZE - 4], "...", 4);
+  return LOGGER_MESSAGE_SIZE - 1;
+}
+
+/**
+  Formats a message into `buffer`, which holds `LOGGER_MESSAGE_SIZE` bytes.
+  Messages that don't fit are formatted onto the heap instead, in which case
+  the caller frees the returned text. If out of memory, the message is cut off.
+*/
+static char* logger_format(
+  char* buffer, size_t* length, const char* format, va_list args
+) {
+  va_list copy;
+  va_copy(copy, args);
+  int result = vsnprintf(buffer, LOGGER_MESSAGE_SIZE, format, args);
+
+  char* text = buffer;
+  if (result < 0) {
+    result = 0;
+  } else if (result >= LOGGER_MESSAGE_SIZE) {
+    if ((text = malloc((size_t)result + 1)))
+      vsnprintf(text, (size_t)result + 1, format, copy);
+    else
+      result = logger_cut(text = buffer);
+  }
+  va_end(copy);
+
+  *length = result;
+  return text;
+}
+
+void logger_init(logger_level_t min_level) {
+  logger_min_level = min_level;
+  logger_epoch = system_clock();
+
+  for (size_t i = 0; i < LOGGER_QUEUE_CAPACITY; i++) {
+    atomic_init(&logger_queue[i].sequence, i);
+    logger_queue[i].heap = NULL;
+  }
+
+  atomic_store(&logger_stopping, false);
+  if (thrd_create(&logger_thread, logger_main, NULL) != thrd_success) {
+    SYSTEM_WARN_LOG("Failed to start the log writer, logging synchronously.");
+    return;
+  }
+  atomic_store(&logger_running, true);
+}
+
+bool logger_enabled(logger_level_t level) {
+  return level >= logger_min_level;
+}
+
+void logger_message(logger_level_t level, const char* message, size_t length) {
+  if (!logger_enabled(level))
+    return;
+
+  double time = logger_time();
+  if (atomic_load(&logger_running) && !logger_allow(level, time)) {
+    logger_drop();
+    return;
+  }
+
+  if (level == LOGGER_LEVEL_FATAL || !atomic_load(&logger_running)) {
+    logger_flush();
+    logger_print(level, time, message, length);
+    fflush(stdout);
+    return;
+  }
+
+  size_t index;
+  logger_entry_t* entry = logger_claim(&index);
+  if (!entry) {
+    logger_drop();
+    return;
+  }
+
+  // Messages too long for the slot go on the heap, or are cut off if out of
+  // memory.
+  char* text = entry->text;
+  bool cut = false;
+  if (length >= LOGGER_MESSAGE_SIZE) {
+    if ((entry->heap = malloc(length))) {
+      text = entry->heap;
+    } else {
+      length = LOGGER_MESSAGE_SIZE - 1;
+      cut = true;
+    }
+  }
+
+  memcpy(text, message, length);
+  if (cut)
+    logger_cut(text);
+
+  entry->level = level;
+  entry->time = time;
+  entry->length = length;
+  logger_publish(entry, index);
+}
+
+void logger_write(logger_level_t level, const char* format, ...) {
+  if (!logger_enabled(level))
+    return;
+
+  double time = logger_time();
+  if (atomic_load(&logger_running) && !logger_allow(level, time)) {
+    logger_drop();
+    return;
+  }
+
+  va_list args;
+  va_start(args, format);
+
+  if (level == LOGGER_LEVEL_FATAL || !atomic_load(&logger_running)) {
+    char buffer[LOGGER_MESSAGE_SIZE];
+    size_t length;
+    char* text = logger_format(buffer, &length, format, args);
+    va_end(args);
+
+    logger_flush();
+    logger_print(level, time, text, length);
+    fflush(stdout);
+    if (text != buffer)
+      free(text);
+    return;
+  }
+
+  size_t index;
+  logger_entry_t* entry = logger_claim(&index);
+  if (!entry) {
+    va_end(args);
+    logger_drop();
+    return;
+  }
+
+  // Formatting straight into the slot avoids a copy.
+  size_t length;
+  char* text = logger_format(entry->text, &length, format, args);
+  va_end(args);
+  if (text != entry->text)
+    entry->heap = text;
+
+  entry->level = level;
+  entry->time = time;
+  entry->length = length;
+  logger_publish(entry, index);
+}
+
+void logger_flush(void) {
+  if (!atomic_load(&logger_running))
+    return;
+
+  const struct timespec poll = {.tv_sec = 0, .tv_nsec = 100000};
+  size_t tail = atomic_load_explicit(&logger_tail, memory_order_acquire);
+  while (atomic_load_explicit(&logger_head, memory_order_acquire) < tail)
+    thrd_sleep(&poll, NULL);
+}
+
+const size_t logger_dropped(void) {
+  return atomic_load_explicit(&logger_dropped_count, memory_order_relaxed);
+}
+
+void logger_free(void) {
+  if (!atomic_exchange(&logger_running, false))
+    return;
+
+  atomic_store(&logger_stopping, true);
+  thrd_join(logger_thread, NULL);
+}
@@ -0,0 +1,90 @@
+/**
+  src/api/logger.h
+
+  Written by DoelJavid for V-GAME.
+
+  https://github.com/DoelJavid/v-game
+*/
+
+#ifndef API_LOGGER_H
+#define API_LOGGER_H
+
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+// How many messages can be waiting to be written. Must be a power of two. Once
+// full, new messages are dropped.
+#define LOGGER_QUEUE_CAPACITY 1024
+
+// The longest message a queue slot holds, including the null terminator.
+// Longer messages are copied to the heap instead.
+#define LOGGER_MESSAGE_SIZE 256
+
+// How many messages below `LOGGER_LEVEL_ERROR` can be logged each second.
+// Anything past that is dropped so a log in the game loop can't flood stdout.
+#define LOGGER_RATE_LIMIT 240
+
+// How long the writer thread sleeps when there's nothing to write.
+#define LOGGER_POLL_SECONDS 0.005
+
+#define LOG_FMT_RESET "\x1b[0m"
+#define LOG_FMT_WARNING "\x1b[33m"
+#define LOG_FMT_ERROR "\x1b[31m"
+
+/**
+  How severe a message is. Messages below the level given to `logger_init()`
+  are discarded.
+*/
+typedef enum {
+  LOGGER_LEVEL_INFO,
+  LOGGER_LEVEL_WARNING,
+  LOGGER_LEVEL_ERROR,
+  LOGGER_LEVEL_FATAL
+} logger_level_t;
+
+/**
+  Starts the writer thread. Until this is called, and after `logger_free()`,
+  messages are written to stdout right away and aren't rate limited. Message
+  times count from when this is called.
+*/
+void logger_init(logger_level_t min_level);
+
+/**
+  Returns true if messages of the given level are written. Callers can check
+  this to skip building messages that would be thrown away.
+*/
+bool logger_enabled(logger_level_t level);
+
+/**
+  Formats a message and queues it to be written. Fatal messages flush the queue
+  and are written before returning, since the program is usually about to
+  exit. Safe to call from any thread.
+*/
+void logger_write(logger_level_t level, const char* format, ...);
+
+/**
+  Queues a message that's already been built, without any formatting.
+*/
+void logger_message(logger_level_t level, const char* message, size_t length);
+
+/**
+  Waits until every queued message has been written.
+*/
+void logger_flush(void);
+
+/**
+  Returns how many messages have been dropped because the queue was full or
+  because of rate limiting.
+*/
+const size_t logger_dropped(void);
+
+/**
+  Writes any remaining messages and stops the writer thread.
+*/
+void logger_free(void);
+
+#endif
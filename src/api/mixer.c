@@ -0,0 +1,229 @@
+/**
+  src/api/mixer.c
+
+  Written by DoelJavid for V-GAME.
+
+  https://github.com/DoelJavid/v-game
+*/
+
+#include "mixer.h"
+
+static int16_t mixer_wave_tables[4][MIXER_WAVE_SIZE];
+static mixer_voice_t mixer_voices[MIXER_VOICES] = {0};
+static int32_t mixer_bus[MIXER_BLOCK_FRAMES * 2];
+
+static int32_t mixer_master_gain = MIXER_UNITY;
+static int32_t mixer_limiter_gain = MIXER_UNITY;
+static uint32_t mixer_noise_seed = 1;
+
+/**
+  Generates a sample of a waveform for the given type.
+
+  Based on this code here:
+  https://github.com/mdcrtr/sound-generator/blob/main/src/sound_gen.c
+*/
+static float step_oscillator(int type, float step) {
+  switch (type) {
+  case 1: // Square Wave
+    return step < 0.5f ? -1.0f : 1.0f;
+  case 2: // Triangle Wave
+    return step < 0.5f ? 4.0f * step - 1.0f : 1.0f - 4.0f * (step - 0.5f);
+  case 3: // Sine Wave
+    return sinf(2.0f * PI * step);
+  default:
+    return sinf(powf(2.0f * PI * step, 3));
+  }
+}
+
+/**
+  Returns how far a voice's phase should step for each sample to play the given
+  semitone.
+*/
+static uint32_t semitone_step(int semitone) {
+  double step = ROOT_NOTE_FREQUENCY * pow(2.0, (double)semitone / 12.0) /
+                SAMPLE_RATE;
+  return (uint32_t)(fmod(step, 1.0) * 4294967296.0);
+}
+
+/**
+  A tiny xorshift generator used for noise. `rand()` isn't guaranteed to be
+  safe to call from the audio thread.
+*/
+static uint32_t next_noise(void) {
+  mixer_noise_seed ^= mixer_noise_seed << 13;
+  mixer_noise_seed ^= mixer_noise_seed >> 17;
+  mixer_noise_seed ^= mixer_noise_seed << 5;
+  return mixer_noise_seed;
+}
+
+/**
+  Converts the given float to a Q15 number, clamping it to the given range.
+*/
+static int32_t to_fixed(float value, float min, float max) {
+  if (value < min)
+    value = min;
+  else if (value > max)
+    value = max;
+  return (int32_t)(value * MIXER_UNITY);
+}
+
+/**
+  Sets the pan of a voice. -1 is fully left, 0 is centered and 1 is fully
+  right. A centered voice plays at full volume on both sides.
+*/
+static void set_pan(mixer_voice_t* voice, float pan) {
+  voice->pan_left = to_fixed(1.0f - pan, 0.0f, 1.0f);
+  voice->pan_right = to_fixed(1.0f + pan, 0.0f, 1.0f);
+}
+
+/**
+  Bends samples above the knee towards full scale so loud mixes round off
+  instead of wrapping or hard clipping. The curve is continuous with a slope
+  of one at the knee and never quite reaches full scale.
+*/
+static inline int16_t soft_clip(int32_t sample) {
+  const int32_t range = 32767 - MIXER_CLIP_KNEE;
+  int32_t magnitude = sample < 0 ? -sample : sample;
+
+  if (magnitude > MIXER_CLIP_KNEE) {
+    int32_t over = magnitude - MIXER_CLIP_KNEE;
+    magnitude =
+      MIXER_CLIP_KNEE + (int32_t)((int64_t)over * range / (over + range));
+  }
+
+  return (int16_t)(sample < 0 ? -magnitude : magnitude);
+}
+
+/**
+  Adds the next block of the given voice to the bus.
+*/
+static void mix_voice(mixer_voice_t* voice, int frames) {
+  const int16_t* table = mixer_wave_tables[voice->type - 1];
+  const bool noisy = voice->type > 3;
+  const int32_t left =
+    (int32_t)(((int64_t)voice->gain * voice->pan_left) >> 15);
+  const int32_t right =
+    (int32_t)(((int64_t)voice->gain * voice->pan_right) >> 15);
+
+  if (frames > voice->frames_left)
+    frames = voice->frames_left;
+
+  uint32_t phase = voice->phase;
+  for (int i = 0; i < frames; i++) {
+    if (noisy && (voice->frame + i) % 64 == 0)
+      phase = (next_noise() & 127) << 25;
+
+    int32_t sample = table[phase >> (32 - MIXER_WAVE_BITS)];
+    mixer_bus[i * 2] += (sample * left) >> 15;
+    mixer_bus[i * 2 + 1] += (sample * right) >> 15;
+    phase += voice->phase_step;
+  }
+
+  voice->phase = phase;
+  voice->frame += frames;
+  voice->frames_left -= frames;
+}
+
+/**
+  Applies the master gain and limiter to the bus, then soft clips it into the
+  given output.
+*/
+static void master_block(short* out, int frames) {
+  int32_t peak = 0;
+  for (int i = 0; i < frames * 2; i++) {
+    mixer_bus[i] = (int32_t)(((int64_t)mixer_bus[i] * mixer_master_gain) >> 15);
+    int32_t magnitude = mixer_bus[i] < 0 ? -mixer_bus[i] : mixer_bus[i];
+    if (magnitude > peak)
+      peak = magnitude;
+  }
+
+  // The whole block is known before it's played, so the limiter can clamp
+  // down instantly without overshooting. It then recovers over a few blocks.
+  int32_t target = MIXER_UNITY;
+  if (peak > MIXER_LIMIT_THRESHOLD)
+    target = (int32_t)((int64_t)MIXER_LIMIT_THRESHOLD * MIXER_UNITY / peak);
+
+  int32_t start = mixer_limiter_gain;
+  int32_t end = start + ((target - start) >> 3);
+  if (target < start)
+    start = end = target;
+
+  for (int i = 0; i < frames; i++) {
+    // Ramp across the block while recovering so gain changes don't click.
+    int32_t gain = start + (end - start) * i / frames;
+
+    out[i * 2] = soft_clip((int32_t)(((int64_t)mixer_bus[i * 2] * gain) >> 15));
+    out[i * 2 + 1] =
+      soft_clip((int32_t)(((int64_t)mixer_bus[i * 2 + 1] * gain) >> 15));
+  }
+
+  mixer_limiter_gain = end;
+}
+
+void mixer_init(void) {
+  for (int type = 1; type <= 4; type++)
+    for (int i = 0; i < MIXER_WAVE_SIZE; i++)
+      mixer_wave_tables[type - 1][i] = (int16_t)(
+        step_oscillator(type, (float)i / MIXER_WAVE_SIZE) * 32767.0f
+      );
+
+  for (int i = 0; i < MIXER_VOICES; i++)
+    mixer_voices[i] = (mixer_voice_t){0};
+
+  mixer_limiter_gain = MIXER_UNITY;
+  mixer_master_gain = MIXER_UNITY;
+}
+
+void mixer_play(int voice, waveform_params_t params) {
+  mixer_voice_t* target = &mixer_voices[voice];
+
+  // Any unknown waveform falls back to noise, like `step_oscillator()`.
+  target->type = params.type >= 1 && params.type <= 3 ? params.type : 4;
+  target->phase = 0;
+  target->phase_step = semitone_step(params.semitone);
+  target->gain = to_fixed(params.volume, 0.0f, 2.0f);
+  target->frames_left = (int)(params.duration * SAMPLE_RATE);
+  target->frame = 0;
+  set_pan(target, params.pan);
+}
+
+void mixer_stop(int voice) {
+  mixer_voices[voice].frames_left = 0;
+}
+
+void mixer_set(int voice, audio_param_t param, float value) {
+  mixer_voice_t* target = &mixer_voices[voice];
+
+  switch (param) {
+  case AUDIO_PARAM_SEMITONE:
+    target->phase_step = semitone_step((int)value);
+    break;
+  case AUDIO_PARAM_VOLUME:
+    target->gain = to_fixed(value, 0.0f, 2.0f);
+    break;
+  case AUDIO_PARAM_PAN:
+    set_pan(target, value);
+    break;
+  }
+}
+
+void mixer_set_master(float gain) {
+  mixer_master_gain = to_fixed(gain, 0.0f, 4.0f);
+}
+
+void mixer_render(short* buffer, unsigned int frames) {
+  while (frames > 0) {
+    int block = frames < MIXER_BLOCK_FRAMES ? frames : MIXER_BLOCK_FRAMES;
+
+    for (int i = 0; i < block * 2; i++)
+      mixer_bus[i] = 0;
+
+    for (int v = 0; v < MIXER_VOICES; v++)
+      if (mixer_voices[v].frames_left > 0)
+        mix_voice(&mixer_voices[v], block);
+
+    master_block(buffer, block);
+    buffer += block * 2;
+    frames -= block;
+  }
+}
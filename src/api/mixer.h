@@ -0,0 +1,77 @@
+/**
+  src/api/mixer.h
+
+  Written by DoelJavid for V-GAME.
+
+  https://github.com/DoelJavid/v-game
+*/
+
+#ifndef API_MIXER_H
+#define API_MIXER_H
+
+#include "audio.h"
+#include <stdint.h>
+
+// How many voices can play at once. Every audio channel owns exactly one voice.
+#define MIXER_VOICES AUDIO_CHANNELS
+
+// How many frames the mixer sums at a time.
+#define MIXER_BLOCK_FRAMES 256
+
+// The wave tables are indexed by the top bits of a voice's 32-bit phase.
+#define MIXER_WAVE_BITS 10
+#define MIXER_WAVE_SIZE (1 << MIXER_WAVE_BITS)
+
+// Fixed-point unity gain. Gains and pans are stored as Q15 numbers.
+#define MIXER_UNITY 32768
+
+// Where the soft-clip curve starts bending, in sample units.
+#define MIXER_CLIP_KNEE 24576
+
+// The level the master limiter holds the bus at before soft clipping.
+#define MIXER_LIMIT_THRESHOLD 65536
+
+/**
+  A single voice within the mixer. Voices are only ever touched by the thread
+  that renders audio.
+*/
+typedef struct {
+  int type;
+  uint32_t phase, phase_step;
+  int32_t gain, pan_left, pan_right;
+  int frames_left, frame;
+} mixer_voice_t;
+
+/**
+  Builds the wave tables and silences every voice.
+*/
+void mixer_init(void);
+
+/**
+  Starts playing the given waveform on the given voice, replacing whatever the
+  voice was playing before.
+*/
+void mixer_play(int voice, waveform_params_t params);
+
+/**
+  Silences the given voice.
+*/
+void mixer_stop(int voice);
+
+/**
+  Changes a parameter of the given voice without restarting it.
+*/
+void mixer_set(int voice, audio_param_t param, float value);
+
+/**
+  Sets the gain of the master bus. 1.0 is unity gain.
+*/
+void mixer_set_master(float gain);
+
+/**
+  Mixes every playing voice into the given buffer of interleaved 16-bit stereo
+  frames. The buffer is filled one block at a time and nothing is allocated.
+*/
+void mixer_render(short* buffer, unsigned int frames);
+
+#endif
@@ -0,0 +1,176 @@
+/**
+  src/api/replay.c
+
+  Written by DoelJavid for V-GAME.
+
+  https://github.com/DoelJavid/v-game
+*/
+
+#include "replay.h"
+
+static INSTANCE_LOCAL FILE* replay_record_file = NULL;
+static INSTANCE_LOCAL input_mask_t replay_run_masks[INPUT_CONTROLLERS] = {0};
+static INSTANCE_LOCAL size_t replay_run_length = 0;
+
+static INSTANCE_LOCAL uint8_t* replay_data = NULL;
+static INSTANCE_LOCAL size_t replay_data_size = 0;
+static INSTANCE_LOCAL size_t replay_data_offset = 0;
+static INSTANCE_LOCAL bool replay_done = false;
+
+/**
+  Writes the current run to the recording and starts a new one.
+*/
+static void flush_run(void) {
+  if (!replay_record_file || replay_run_length == 0)
+    return;
+
+  size_t length = replay_run_length;
+  do {
+    uint8_t byte = length & 0x7f;
+    length >>= 7;
+    fputc(length ? byte | 0x80 : byte, replay_record_file);
+  } while (length);
+
+  for (int i = 0; i < INPUT_CONTROLLERS; i++) {
+    fputc(replay_run_masks[i] & 0xff, replay_record_file);
+    fputc(replay_run_masks[i] >> 8, replay_record_file);
+  }
+
+  replay_run_length = 0;
+}
+
+/**
+  Reads the next run from the replay. Returns false if the replay has run out
+  or is truncated.
+*/
+static bool read_run(void) {
+  size_t length = 0;
+  int shift = 0;
+  uint8_t byte;
+
+  do {
+    if (replay_data_offset >= replay_data_size || shift > 56)
+      return false;
+    byte = replay_data[replay_data_offset++];
+    length |= (size_t)(byte & 0x7f) << shift;
+    shift += 7;
+  } while (byte & 0x80);
+
+  if (replay_data_size - replay_data_offset < INPUT_CONTROLLERS * 2)
+    return false;
+
+  for (int i = 0; i < INPUT_CONTROLLERS; i++) {
+    const uint8_t* mask = &replay_data[replay_data_offset + i * 2];
+    replay_run_masks[i] = mask[0] | mask[1] << 8;
+  }
+
+  replay_data_offset += INPUT_CONTROLLERS * 2;
+  replay_run_length = length;
+  return true;
+}
+
+/**
+  Loads the whole replay file into memory and validates its header.
+*/
+static int open_replay(const char* path) {
+  FILE* file = fopen(path, "rb");
+  if (!file) {
+    SYSTEM_ERROR_LOG("Failed to open input replay \"%s\"!", path);
+    return 1;
+  }
+
+  fseek(file, 0, SEEK_END);
+  long size = ftell(file);
+  fseek(file, 0, SEEK_SET);
+
+  replay_data = size > 0 ? malloc(size) : NULL;
+  if (!replay_data || fread(replay_data, 1, size, file) != (size_t)size) {
+    SYSTEM_ERROR_LOG("Failed to read input replay \"%s\"!", path);
+    fclose(file);
+    return 1;
+  }
+  fclose(file);
+
+  replay_data_size = size;
+  if (size < 8 || memcmp(replay_data, REPLAY_MAGIC, 4) != 0 ||
+      replay_data[4] != REPLAY_VERSION ||
+      replay_data[5] != INPUT_CONTROLLERS) {
+    SYSTEM_ERROR_LOG("\"%s\" is not a valid input replay!", path);
+    return 1;
+  }
+
+  replay_data_offset = 8;
+  return 0;
+}
+
+/**
+  Creates the recording file and writes its header.
+*/
+static int open_record(const char* path) {
+  replay_record_file = fopen(path, "wb");
+  if (!replay_record_file) {
+    SYSTEM_ERROR_LOG("Failed to create input recording \"%s\"!", path);
+    return 1;
+  }
+
+  const uint8_t header[8] = {
+    REPLAY_MAGIC[0], REPLAY_MAGIC[1], REPLAY_MAGIC[2], REPLAY_MAGIC[3],
+    REPLAY_VERSION,  INPUT_CONTROLLERS
+  };
+  fwrite(header, 1, sizeof(header), replay_record_file);
+  return 0;
+}
+
+int replay_init(const char* record_path, const char* replay_path) {
+  if (replay_path) {
+    if (record_path)
+      SYSTEM_WARN_LOG("Can't record input while replaying! Only replaying.");
+
+    SYSTEM_LOG("Replaying input from %s", replay_path);
+    return open_replay(replay_path);
+  }
+
+  if (record_path) {
+    SYSTEM_LOG("Recording input to %s", record_path);
+    return open_record(record_path);
+  }
+
+  return 0;
+}
+
+void replay_frame(input_mask_t masks[INPUT_CONTROLLERS]) {
+  if (replay_data) {
+    if (replay_run_length == 0 && !read_run()) {
+      replay_done = true;
+      memset(masks, 0, sizeof(input_mask_t) * INPUT_CONTROLLERS);
+      return;
+    }
+
+    memcpy(masks, replay_run_masks, sizeof(replay_run_masks));
+    replay_run_length--;
+  } else if (replay_record_file) {
+    if (replay_run_length > 0 &&
+        memcmp(masks, replay_run_masks, sizeof(replay_run_masks)) != 0)
+      flush_run();
+
+    memcpy(replay_run_masks, masks, sizeof(replay_run_masks));
+    replay_run_length++;
+  }
+}
+
+bool replay_finished(void) {
+  return replay_done;
+}
+
+void replay_free(void) {
+  if (replay_record_file) {
+    flush_run();
+    fclose(replay_record_file);
+    replay_record_file = NULL;
+  }
+
+  if (replay_data) {
+    free(replay_data);
+    replay_data = NULL;
+  }
+}
@@ -0,0 +1,52 @@
+/**
+  src/api/replay.h
+
+  Written by DoelJavid for V-GAME.
+
+  https://github.com/DoelJavid/v-game
+*/
+
+#ifndef API_REPLAY_H
+#define API_REPLAY_H
+
+#include "input.h"
+#include "system.h"
+#include <stdint.h>
+#include <string.h>
+
+#define REPLAY_MAGIC "VGIN"
+#define REPLAY_VERSION 1
+
+/**
+  Starts recording or replaying input. Either path may be NULL. Recording and
+  replaying at the same time isn't supported, so if both paths are given only
+  the replay is used.
+
+  Returns 0 on success and 1 if the file couldn't be opened or isn't a valid
+  input recording.
+
+  A replay file stores the button masks of every controller for every
+  interrupt as a stream of runs. Each run is a LEB128 varint holding how many
+  interrupts in a row had the same input, followed by one little-endian 16-bit
+  mask per controller.
+*/
+int replay_init(const char* record_path, const char* replay_path);
+
+/**
+  Called by `input_poll()` with the freshly sampled masks of every controller.
+  While recording, the masks are appended to the recording. While replaying,
+  the masks are overwritten with the recorded ones.
+*/
+void replay_frame(input_mask_t masks[INPUT_CONTROLLERS]);
+
+/**
+  Returns true once a replay has run out of recorded input.
+*/
+bool replay_finished(void);
+
+/**
+  Flushes any pending recording to disk and closes the replay files.
+*/
+void replay_free(void);
+
+#endif
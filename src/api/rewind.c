@@ -0,0 +1,268 @@
+/**
+  src/api/rewind.c
+
+  Written by DoelJavid for V-GAME.
+
+  https://github.com/DoelJavid/v-game
+*/
+
+#include "rewind.h"
+
+/**
+  A snapshot stored as a delta against the snapshot after it.
+*/
+typedef struct {
+  uint8_t* delta;
+  size_t length;
+  size_t snapshot_length;
+} rewind_frame_t;
+
+// The newest snapshot, which the deltas are undone against.
+static INSTANCE_LOCAL uint8_t* rewind_head = NULL;
+static INSTANCE_LOCAL size_t rewind_head_length = 0;
+static INSTANCE_LOCAL size_t rewind_head_capacity = 0;
+static INSTANCE_LOCAL bool rewind_has_head = false;
+
+// Deltas in order from oldest to newest, starting at `rewind_first`.
+static INSTANCE_LOCAL rewind_frame_t rewind_ring[REWIND_MAX_FRAMES];
+static INSTANCE_LOCAL size_t rewind_first = 0;
+static INSTANCE_LOCAL size_t rewind_count = 0;
+static INSTANCE_LOCAL size_t rewind_bytes = 0;
+
+static INSTANCE_LOCAL uint8_t* rewind_scratch = NULL;
+static INSTANCE_LOCAL size_t rewind_scratch_capacity = 0;
+
+/**
+  Grows the given buffer to hold at least `size` bytes. Returns false if out of
+  memory.
+*/
+static bool reserve(uint8_t** buffer, size_t* capacity, size_t size) {
+  if (size <= *capacity)
+    return true;
+
+  size_t new_capacity = *capacity ? *capacity : 256;
+  while (new_capacity < size)
+    new_capacity *= 2;
+
+  uint8_t* data = realloc(*buffer, new_capacity);
+  if (!data)
+    return false;
+
+  *buffer = data;
+  *capacity = new_capacity;
+  return true;
+}
+
+/**
+  Writes an unsigned LEB128 varint at `*offset` and moves the offset past it.
+*/
+static void put_varint(uint8_t* data, size_t* offset, size_t value) {
+  do {
+    uint8_t byte = value & 0x7f;
+    value >>= 7;
+    data[(*offset)++] = value ? byte | 0x80 : byte;
+  } while (value);
+}
+
+/**
+  Reads an unsigned LEB128 varint at `*offset` and moves the offset past it.
+*/
+static bool get_varint(
+  const uint8_t* data, size_t length, size_t* offset, size_t* value
+) {
+  size_t result = 0;
+  int shift = 0;
+  uint8_t byte;
+
+  do {
+    if (*offset >= length || shift > 63)
+      return false;
+    byte = data[(*offset)++];
+    result |= (size_t)(byte & 0x7f) << shift;
+    shift += 7;
+  } while (byte & 0x80);
+
+  *value = result;
+  return true;
+}
+
+/**
+  Returns the byte of a snapshot at the given offset, where snapshots are
+  treated as if they were followed by zeroes.
+*/
+static inline uint8_t byte_at(const uint8_t* data, size_t length, size_t i) {
+  return i < length ? data[i] : 0;
+}
+
+/**
+  Writes the delta turning `newer` back into `older` to the scratch buffer and
+  returns its length, or 0 if out of memory. The delta is a list of runs, each
+  a varint count of unchanged bytes, a varint count of changed bytes, and the
+  changed bytes XORed with the newer snapshot's.
+*/
+static size_t encode_delta(
+  const uint8_t* older, size_t older_length, const uint8_t* newer,
+  size_t newer_length
+) {
+  // Runs never take more than three bytes per byte of the snapshot.
+  size_t capacity = older_length * 3 + 32;
+  if (!reserve(&rewind_scratch, &rewind_scratch_capacity, capacity))
+    return 0;
+
+  size_t length = 0;
+  size_t i = 0;
+  while (i < older_length) {
+    size_t same_start = i;
+    while (i < older_length && older[i] == byte_at(newer, newer_length, i))
+      i++;
+
+    size_t diff_start = i;
+    while (i < older_length && older[i] != byte_at(newer, newer_length, i))
+      i++;
+
+    put_varint(rewind_scratch, &length, diff_start - same_start);
+    put_varint(rewind_scratch, &length, i - diff_start);
+    for (size_t j = diff_start; j < i; j++)
+      rewind_scratch[length++] = older[j] ^ byte_at(newer, newer_length, j);
+  }
+
+  // Keeps empty deltas from looking like a failure.
+  if (length == 0) {
+    put_varint(rewind_scratch, &length, 0);
+    put_varint(rewind_scratch, &length, 0);
+  }
+
+  return length;
+}
+
+/**
+  Turns the head back into the snapshot the given delta was made from.
+*/
+static bool apply_delta(const rewind_frame_t* frame) {
+  size_t length = frame->snapshot_length;
+  if (!reserve(&rewind_head, &rewind_head_capacity, length))
+    return false;
+  if (length > rewind_head_length)
+    memset(&rewind_head[rewind_head_length], 0, length - rewind_head_length);
+
+  size_t offset = 0, i = 0;
+  while (offset < frame->length) {
+    size_t same, diff;
+    if (!get_varint(frame->delta, frame->length, &offset, &same) ||
+        !get_varint(frame->delta, frame->length, &offset, &diff) ||
+        same > length - i || diff > length - i - same ||
+        diff > frame->length - offset)
+      return false;
+
+    i += same;
+    for (size_t j = 0; j < diff; j++)
+      rewind_head[i++] ^= frame->delta[offset++];
+  }
+
+  rewind_head_length = length;
+  return true;
+}
+
+/**
+  Drops the oldest delta.
+*/
+static void drop_oldest(void) {
+  rewind_frame_t* frame = &rewind_ring[rewind_first];
+  rewind_bytes -= frame->length;
+  free(frame->delta);
+  frame->delta = NULL;
+
+  rewind_first = (rewind_first + 1) % REWIND_MAX_FRAMES;
+  rewind_count--;
+}
+
+/**
+  Drops every delta, keeping the head.
+*/
+static void drop_all(void) {
+  while (rewind_count > 0)
+    drop_oldest();
+  rewind_first = 0;
+}
+
+void rewind_push(const void* data, size_t length) {
+  if (rewind_has_head) {
+    size_t delta_length =
+      encode_delta(rewind_head, rewind_head_length, data, length);
+    uint8_t* delta = delta_length ? malloc(delta_length) : NULL;
+
+    // Every delta depends on the ones after it, so losing one loses them all.
+    if (!delta || delta_length > REWIND_MAX_BYTES) {
+      free(delta);
+      drop_all();
+    } else {
+      while (rewind_count > 0 &&
+             (rewind_count == REWIND_MAX_FRAMES ||
+              rewind_bytes + delta_length > REWIND_MAX_BYTES))
+        drop_oldest();
+
+      memcpy(delta, rewind_scratch, delta_length);
+      rewind_frame_t* frame =
+        &rewind_ring[(rewind_first + rewind_count) % REWIND_MAX_FRAMES];
+      frame->delta = delta;
+      frame->length = delta_length;
+      frame->snapshot_length = rewind_head_length;
+      rewind_count++;
+      rewind_bytes += delta_length;
+    }
+  }
+
+  if (!reserve(&rewind_head, &rewind_head_capacity, length)) {
+    drop_all();
+    rewind_has_head = false;
+    return;
+  }
+
+  memcpy(rewind_head, data, length);
+  rewind_head_length = length;
+  rewind_has_head = true;
+}
+
+const void* rewind_pop(size_t* length) {
+  if (rewind_count == 0)
+    return NULL;
+
+  size_t newest = (rewind_first + rewind_count - 1) % REWIND_MAX_FRAMES;
+  rewind_frame_t* frame = &rewind_ring[newest];
+  bool applied = apply_delta(frame);
+
+  rewind_bytes -= frame->length;
+  free(frame->delta);
+  frame->delta = NULL;
+  rewind_count--;
+
+  if (!applied) {
+    SYSTEM_WARN_LOG("Failed to rewind, dropping the rewind buffer.");
+    drop_all();
+    rewind_has_head = false;
+    return NULL;
+  }
+
+  *length = rewind_head_length;
+  return rewind_head;
+}
+
+size_t rewind_frames(void) {
+  return rewind_count;
+}
+
+bool rewind_held(void) {
+  return !system_headless() && IsKeyDown(REWIND_KEY);
+}
+
+void rewind_free(void) {
+  drop_all();
+  free(rewind_head);
+  free(rewind_scratch);
+  rewind_head = NULL;
+  rewind_scratch = NULL;
+  rewind_head_length = 0;
+  rewind_head_capacity = 0;
+  rewind_scratch_capacity = 0;
+  rewind_has_head = false;
+}
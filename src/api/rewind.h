@@ -0,0 +1,61 @@
+/**
+  src/api/rewind.h
+
+  Written by DoelJavid for V-GAME.
+
+  https://github.com/DoelJavid/v-game
+*/
+
+#ifndef API_REWIND_H
+#define API_REWIND_H
+
+#include "system.h"
+#include <stdint.h>
+#include <string.h>
+
+// How many snapshots the rewind buffer keeps, which is 10 seconds of ticks.
+#define REWIND_MAX_FRAMES (SYSTEM_TICK_RATE * 10)
+
+// How many bytes of deltas the rewind buffer keeps before dropping the oldest
+// snapshots.
+#define REWIND_MAX_BYTES (8 * 1024 * 1024)
+
+// The key that rewinds the game while held.
+#define REWIND_KEY KEY_F8
+
+/**
+  Adds a snapshot to the rewind buffer. The snapshot is copied, so the caller
+  keeps ownership of the data.
+
+  Only the newest snapshot is kept whole. Older ones are stored as deltas
+  that turn the snapshot after them back into them: the bytes of both
+  snapshots XORed together, written as runs of unchanged bytes and runs of
+  changed ones. Snapshots that barely change from tick to tick take a few
+  bytes each. Once the buffer holds `REWIND_MAX_FRAMES` deltas or
+  `REWIND_MAX_BYTES` bytes of them, the oldest are dropped.
+*/
+void rewind_push(const void* data, size_t length);
+
+/**
+  Drops the newest snapshot and returns the one before it, writing its size to
+  `length`. The returned data stays valid until the rewind buffer changes.
+  Returns NULL if there's nothing to rewind to.
+*/
+const void* rewind_pop(size_t* length);
+
+/**
+  Returns how many times `rewind_pop()` can be called.
+*/
+size_t rewind_frames(void);
+
+/**
+  Returns true while the player is holding `REWIND_KEY`.
+*/
+bool rewind_held(void);
+
+/**
+  Drops every snapshot.
+*/
+void rewind_free(void);
+
+#endif
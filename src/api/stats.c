@@ -0,0 +1,89 @@
+/**
+  src/api/stats.c
+
+  Written by DoelJavid for V-GAME.
+
+  https://github.com/DoelJavid/v-game
+*/
+
+#include "stats.h"
+
+/**
+  Comparison function used by `qsort()` to order samples.
+*/
+static int compare_samples(const void* a, const void* b) {
+  double x = *(const double*)a, y = *(const double*)b;
+  return (x > y) - (x < y);
+}
+
+/**
+  Returns the given percentile of an already sorted array using the
+  nearest-rank method.
+*/
+static double percentile(const double* sorted, size_t count, double p) {
+  size_t rank = (size_t)(p * count + 0.5);
+  if (rank < 1)
+    rank = 1;
+  if (rank > count)
+    rank = count;
+  return sorted[rank - 1];
+}
+
+bool stats_init(stats_t* stats, size_t capacity) {
+  *stats = (stats_t){0};
+  stats->samples = malloc(capacity * sizeof(double));
+  if (!stats->samples)
+    return false;
+
+  stats->capacity = capacity;
+  return true;
+}
+
+void stats_push(stats_t* stats, double sample) {
+  if (!stats->samples)
+    return;
+
+  stats->samples[stats->next] = sample;
+  stats->next = (stats->next + 1) % stats->capacity;
+  if (stats->count < stats->capacity)
+    stats->count++;
+}
+
+void stats_reset(stats_t* stats) {
+  stats->count = 0;
+  stats->next = 0;
+}
+
+stats_summary_t stats_summarize(const stats_t* stats) {
+  stats_summary_t summary = {0};
+  if (!stats->samples || stats->count == 0)
+    return summary;
+
+  double* sorted = malloc(stats->count * sizeof(double));
+  if (!sorted)
+    return summary;
+
+  memcpy(sorted, stats->samples, stats->count * sizeof(double));
+  qsort(sorted, stats->count, sizeof(double), compare_samples);
+
+  double sum = 0;
+  for (size_t i = 0; i < stats->count; i++)
+    sum += sorted[i];
+
+  summary.count = stats->count;
+  summary.min = sorted[0];
+  summary.max = sorted[stats->count - 1];
+  summary.mean = sum / stats->count;
+  summary.p50 = percentile(sorted, stats->count, 0.50);
+  summary.p95 = percentile(sorted, stats->count, 0.95);
+  summary.p99 = percentile(sorted, stats->count, 0.99);
+
+  free(sorted);
+  return summary;
+}
+
+void stats_free(stats_t* stats) {
+  if (stats->samples)
+    free(stats->samples);
+  *stats = (stats_t){0};
+}
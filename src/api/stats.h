@@ -0,0 +1,61 @@
+/**
+  src/api/stats.h
+
+  Written by DoelJavid for V-GAME.
+
+  https://github.com/DoelJavid/v-game
+*/
+
+#ifndef API_STATS_H
+#define API_STATS_H
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+  A fixed-size ring of timing samples. Once full, new samples overwrite the
+  oldest ones, so pushing a sample never allocates.
+*/
+typedef struct {
+  double* samples;
+  size_t capacity, count, next;
+} stats_t;
+
+/**
+  A summary of the samples within a `stats_t`. All percentiles are taken over
+  the samples currently held in the ring.
+*/
+typedef struct {
+  size_t count;
+  double min, max, mean, p50, p95, p99;
+} stats_summary_t;
+
+/**
+  Allocates room for the given number of samples. Returns false if the
+  allocation failed.
+*/
+bool stats_init(stats_t* stats, size_t capacity);
+
+/**
+  Records a sample. Does nothing if the stats were never initialized.
+*/
+void stats_push(stats_t* stats, double sample);
+
+/**
+  Forgets every sample without releasing memory.
+*/
+void stats_reset(stats_t* stats);
+
+/**
+  Summarizes the samples currently held. This sorts a copy of the samples, so
+  it's meant for reports rather than for every frame.
+*/
+stats_summary_t stats_summarize(const stats_t* stats);
+
+/**
+  Releases the memory held by the given stats.
+*/
+void stats_free(stats_t* stats);
+
+#endif
@@ -0,0 +1,279 @@
+/**
+  src/api/storage.c
+
+  Written by DoelJavid for V-GAME.
+
+  https://github.com/DoelJavid/v-game
+*/
+
+#include "storage.h"
+#include <threads.h>
+
+/**
+  A save waiting to be written. `writing` is set while the writer thread owns
+  the entry, so saving the same file again queues a new entry instead of
+  replacing the data being written.
+*/
+typedef struct storage_entry_t {
+  struct storage_entry_t* next;
+  char path[STORAGE_MAX_PATH];
+  void* data;
+  size_t length;
+  bool writing;
+} storage_entry_t;
+
+// The path of the game without its extension, which save paths start with.
+static INSTANCE_LOCAL char* storage_prefix = NULL;
+
+// The writer thread and its queue are shared by every game in the process.
+static once_flag storage_once = ONCE_FLAG_INIT;
+static mtx_t storage_lock;
+static cnd_t storage_wake;
+static thrd_t storage_thread;
+static bool storage_running = false;
+static bool storage_stopping = false;
+
+static storage_entry_t* storage_head = NULL;
+static storage_entry_t* storage_tail = NULL;
+
+/**
+  Writes the path of the save with the given key to `path`. Returns false if
+  it doesn't fit.
+*/
+static bool save_path(const char* key, char* path) {
+  int length = snprintf(
+    path, STORAGE_MAX_PATH, "%s.%s%s", storage_prefix ? storage_prefix : "save",
+    key, STORAGE_EXTENSION
+  );
+  return length > 0 && length < STORAGE_MAX_PATH;
+}
+
+/**
+  Writes the given data to the save at the given path. The data is written to
+  a temporary file first and then renamed over the save.
+*/
+static void write_save(const char* path, const void* data, size_t length) {
+  char temp_path[STORAGE_MAX_PATH + 4];
+  snprintf(temp_path, sizeof(temp_path), "%s.tmp", path);
+
+  // The save is synced before it replaces the old one, so a crash or power
+  // loss can't leave an empty save behind.
+  FILE* file = fopen(temp_path, "wb");
+  bool written = file && fwrite(data, 1, length, file) == length &&
+                 system_sync_file(file);
+  if (file && fclose(file) != 0)
+    written = false;
+
+  if (!written || !system_replace_file(temp_path, path)) {
+    remove(temp_path);
+    SYSTEM_WARN_LOG("Failed to write save \"%s\"!", path);
+  }
+}
+
+/**
+  The writer thread. Writes queued saves in order until stopped, and only
+  stops once the queue is empty.
+*/
+static int storage_main(void* arg) {
+  (void)arg;
+
+  mtx_lock(&storage_lock);
+  for (;;) {
+    while (!storage_head && !storage_stopping)
+      cnd_wait(&storage_wake, &storage_lock);
+
+    storage_entry_t* entry = storage_head;
+    if (!entry)
+      break;
+
+    // The entry stays queued while it's written so reads still find it.
+    entry->writing = true;
+    mtx_unlock(&storage_lock);
+    write_save(entry->path, entry->data, entry->length);
+    mtx_lock(&storage_lock);
+
+    storage_head = entry->next;
+    if (storage_tail == entry)
+      storage_tail = NULL;
+    free(entry->data);
+    free(entry);
+  }
+  mtx_unlock(&storage_lock);
+
+  return 0;
+}
+
+/**
+  Starts the writer thread. Only ever runs once per process.
+*/
+static void start_writer(void) {
+  if (mtx_init(&storage_lock, mtx_plain) != thrd_success)
+    goto failed;
+  if (cnd_init(&storage_wake) != thrd_success) {
+    mtx_destroy(&storage_lock);
+    goto failed;
+  }
+  if (thrd_create(&storage_thread, storage_main, NULL) != thrd_success) {
+    cnd_destroy(&storage_wake);
+    mtx_destroy(&storage_lock);
+    goto failed;
+  }
+
+  storage_running = true;
+  return;
+
+failed:
+  SYSTEM_WARN_LOG("Failed to start the save writer, saving synchronously.");
+}
+
+void storage_init(const char* game_path) {
+  storage_close();
+  call_once(&storage_once, start_writer);
+
+  // Saves are named after the game, so drop the extension.
+  size_t length = strlen(game_path);
+  size_t end = length;
+  while (end > 0 && game_path[end - 1] != '.' && game_path[end - 1] != '/' &&
+         game_path[end - 1] != '\\')
+    end--;
+  if (end == 0 || game_path[end - 1] != '.')
+    end = length + 1;
+
+  // Instances started by the runner each get their own saves.
+  char instance[32] = "";
+  if (system_instance() > 0)
+    snprintf(instance, sizeof(instance), ".%zu", system_instance());
+
+  if (!(storage_prefix = malloc(end + strlen(instance)))) {
+    SYSTEM_WARN_LOG("Failed to set up saves!");
+    return;
+  }
+  memcpy(storage_prefix, game_path, end - 1);
+  strcpy(&storage_prefix[end - 1], instance);
+}
+
+bool storage_valid_key(const char* key) {
+  size_t length = strlen(key);
+  if (length == 0 || length > STORAGE_MAX_KEY)
+    return false;
+
+  for (size_t i = 0; i < length; i++) {
+    char c = key[i];
+    if (!(c >= 'a' && c <= 'z') && !(c >= 'A' && c <= 'Z') &&
+        !(c >= '0' && c <= '9') && c != '-' && c != '_')
+      return false;
+  }
+
+  return true;
+}
+
+bool storage_write(const char* key, void* data, size_t length) {
+  char path[STORAGE_MAX_PATH];
+  if (!storage_valid_key(key) || !save_path(key, path)) {
+    free(data);
+    return false;
+  }
+
+  if (!storage_running) {
+    write_save(path, data, length);
+    free(data);
+    return true;
+  }
+
+  mtx_lock(&storage_lock);
+  for (storage_entry_t* entry = storage_head; entry; entry = entry->next) {
+    if (!entry->writing && strcmp(entry->path, path) == 0) {
+      free(entry->data);
+      entry->data = data;
+      entry->length = length;
+      mtx_unlock(&storage_lock);
+      return true;
+    }
+  }
+
+  storage_entry_t* entry = malloc(sizeof(storage_entry_t));
+  if (!entry) {
+    mtx_unlock(&storage_lock);
+    free(data);
+    return false;
+  }
+
+  strcpy(entry->path, path);
+  entry->next = NULL;
+  entry->data = data;
+  entry->length = length;
+  entry->writing = false;
+  if (storage_tail)
+    storage_tail->next = entry;
+  else
+    storage_head = entry;
+  storage_tail = entry;
+
+  cnd_signal(&storage_wake);
+  mtx_unlock(&storage_lock);
+  return true;
+}
+
+bool storage_read(const char* key, storage_blob_t* blob) {
+  char path[STORAGE_MAX_PATH];
+  if (!storage_valid_key(key) || !save_path(key, path))
+    return false;
+
+  // The newest queued save wins over older ones and over the file.
+  if (storage_running) {
+    mtx_lock(&storage_lock);
+    storage_entry_t* newest = NULL;
+    for (storage_entry_t* entry = storage_head; entry; entry = entry->next) {
+      if (strcmp(entry->path, path) == 0)
+        newest = entry;
+    }
+
+    void* data = newest ? malloc(newest->length ? newest->length : 1) : NULL;
+    if (data)
+      memcpy(data, newest->data, newest->length);
+    mtx_unlock(&storage_lock);
+
+    if (newest) {
+      if (!data)
+        return false;
+      blob->data = data;
+      blob->length = newest->length;
+      blob->mapped = false;
+      return true;
+    }
+  }
+
+  blob->length = 0;
+  blob->mapped = true;
+  blob->data = system_map_file(path, &blob->length);
+  return blob->data != NULL;
+}
+
+void storage_release(storage_blob_t* blob) {
+  if (blob->mapped)
+    system_unmap_file(blob->data, blob->length);
+  else
+    free((void*)blob->data);
+  blob->data = NULL;
+}
+
+void storage_close(void) {
+  free(storage_prefix);
+  storage_prefix = NULL;
+}
+
+void storage_free(void) {
+  storage_close();
+  if (!storage_running)
+    return;
+
+  mtx_lock(&storage_lock);
+  storage_stopping = true;
+  cnd_signal(&storage_wake);
+  mtx_unlock(&storage_lock);
+
+  thrd_join(storage_thread, NULL);
+  cnd_destroy(&storage_wake);
+  mtx_destroy(&storage_lock);
+  storage_running = false;
+}
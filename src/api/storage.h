@@ -0,0 +1,85 @@
+/**
+  src/api/storage.h
+
+  Written by DoelJavid for V-GAME.
+
+  https://github.com/DoelJavid/v-game
+*/
+
+#ifndef API_STORAGE_H
+#define API_STORAGE_H
+
+#include "system.h"
+#include <string.h>
+
+// Added to the path of the game, minus its extension, along with the key to
+// get the path of a save.
+#define STORAGE_EXTENSION ".save"
+
+// The longest key a save can have.
+#define STORAGE_MAX_KEY 64
+
+// The longest path a save can have, including the terminator.
+#define STORAGE_MAX_PATH 4096
+
+/**
+  A save read by `storage_read()`.
+*/
+typedef struct {
+  const void* data;
+  size_t length;
+  // Set if the data is mapped straight from the save file rather than copied.
+  bool mapped;
+} storage_blob_t;
+
+/**
+  Sets up saves for the game at the given path, starting the thread that
+  writes saves if it isn't running yet. Saves are stored next to the game,
+  named after the game and their key. Instances started by the runner also
+  have their instance number in the name, so they don't share saves.
+*/
+void storage_init(const char* game_path);
+
+/**
+  Returns true if the given key can be used to name a save. Keys are made of
+  letters, digits, `-` and `_`.
+*/
+bool storage_valid_key(const char* key);
+
+/**
+  Queues the given data to be saved under the given key and takes ownership of
+  it, so it must have been allocated with `malloc()`. Never waits for the disk.
+  The save is written to a temporary file first and then renamed, so an
+  interrupted write never leaves a broken save behind. Saving the same key
+  again before the previous save was written replaces it.
+
+  Returns false if the data couldn't be queued, in which case it's freed.
+*/
+bool storage_write(const char* key, void* data, size_t length);
+
+/**
+  Reads the save with the given key into `blob`. Returns false if there's no
+  save. Saves still waiting to be written are read as well, and saves on disk
+  are mapped into memory instead of being copied. The blob must be released
+  with `storage_release()`.
+*/
+bool storage_read(const char* key, storage_blob_t* blob);
+
+/**
+  Releases a save read by `storage_read()`.
+*/
+void storage_release(storage_blob_t* blob);
+
+/**
+  Forgets the game set up by `storage_init()`. Saves it queued are still
+  written.
+*/
+void storage_close(void);
+
+/**
+  Writes every queued save, then stops the writer thread. Saves made after
+  this are written right away instead.
+*/
+void storage_free(void);
+
+#endif
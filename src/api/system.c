@@ -7,24 +7,238 @@
 */
 
 #include "system.h"
+#include "audio.h"
+#include "bench.h"
+#include "input.h"
+#include "latency.h"
+#include "replay.h"
+#include "trace.h"
+#include <threads.h>
 
-static RenderTexture2D system_framebuffer;
-static size_t current_tick = 0;
+#if defined(_WIN32)
+// <windows.h> clashes with raylib's names, so the few Win32 functions needed
+// are declared here instead. `long long` has the layout of `LARGE_INTEGER`.
+__declspec(dllimport) int __stdcall QueryPerformanceCounter(long long* count);
+__declspec(dllimport) int __stdcall QueryPerformanceFrequency(
+  long long* frequency
+);
+__declspec(dllimport) int __stdcall MoveFileExA(
+  const char* existing, const char* replacement, unsigned long flags
+);
+#define MOVEFILE_REPLACE_EXISTING 0x1
+#define MOVEFILE_WRITE_THROUGH 0x8
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static INSTANCE_LOCAL RenderTexture2D system_framebuffer;
+static INSTANCE_LOCAL size_t current_tick = 0;
+static INSTANCE_LOCAL bool system_is_headless = false;
+static INSTANCE_LOCAL size_t system_instance_id = 0;
+static INSTANCE_LOCAL size_t system_max_ticks = 0;
+
+// Uncapped runtimes never wait for deadlines or skip frames.
+static INSTANCE_LOCAL bool system_uncapped = false;
+
+// The time the next present is due and the last time a frame was presented.
+static INSTANCE_LOCAL double system_deadline = 0.0;
+static INSTANCE_LOCAL double system_last_present = 0.0;
+
+// The frame skipping decision is made once per tick, either by
+// `graphics_draw()` or by the interrupt itself, whichever asks first.
+static INSTANCE_LOCAL bool system_skip = false;
+static INSTANCE_LOCAL size_t system_skip_tick = (size_t)-1;
+static INSTANCE_LOCAL int system_skips_in_row = 0;
+static INSTANCE_LOCAL size_t system_skipped_frames = 0;
+
+static INSTANCE_LOCAL bool system_dump_key_down = false;
+
+static INSTANCE_LOCAL bool system_is_running = true;
+static INSTANCE_LOCAL int system_status = 0;
+
+static INSTANCE_LOCAL stats_t system_frame_times;
+static INSTANCE_LOCAL stats_t system_lateness;
+static INSTANCE_LOCAL stats_t system_gc_times;
+static INSTANCE_LOCAL stats_t system_heap_sizes;
+
+static INSTANCE_LOCAL system_idle_t system_idle = NULL;
+
+/**
+  Hands the time until the given deadline to the idle callback, if there is
+  one.
+*/
+static void run_idle(double deadline) {
+  if (!system_idle)
+    return;
+
+  bench_phase(BENCH_PHASE_IDLE);
+  system_idle(deadline);
+  bench_phase(BENCH_PHASE_PRESENT);
+}
+
+/**
+  Waits until the given timestamp. Sleeps while the deadline is far away, then
+  spins for the last stretch since OS sleeps aren't precise enough to hit a
+  deadline on their own.
+*/
+static void wait_until(double deadline) {
+  for (;;) {
+    double remaining = deadline - system_clock();
+    if (remaining <= 0.0)
+      return;
+
+    if (remaining > SYSTEM_SPIN_SECONDS) {
+      double sleep = remaining - SYSTEM_SPIN_SECONDS;
+      struct timespec duration = {
+        .tv_sec = (time_t)sleep,
+        .tv_nsec = (long)((sleep - (double)(time_t)sleep) * 1e9)
+      };
+      thrd_sleep(&duration, NULL);
+    }
+  }
+}
+
+double system_clock(void) {
+#if defined(_WIN32)
+  // The wall clock can jump when it's adjusted, so the performance counter is
+  // used instead, like `CLOCK_MONOTONIC` elsewhere.
+  long long count, frequency;
+  QueryPerformanceCounter(&count);
+  QueryPerformanceFrequency(&frequency);
+  return (double)(count / frequency) +
+         (double)(count % frequency) / (double)frequency;
+#else
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+#endif
+}
+
+const void* system_map_file(const char* path, size_t* size) {
+#if defined(_WIN32)
+  FILE* file = fopen(path, "rb");
+  if (!file)
+    return NULL;
+
+  void* data = NULL;
+  long length;
+  if (fseek(file, 0, SEEK_END) == 0 && (length = ftell(file)) > 0 &&
+      fseek(file, 0, SEEK_SET) == 0 && (data = malloc(length))) {
+    if (fread(data, 1, length, file) != (size_t)length) {
+      free(data);
+      data = NULL;
+    }
+    *size = length;
+  }
+
+  fclose(file);
+  return data;
+#else
+  int fd = open(path, O_RDONLY);
+  if (fd < 0)
+    return NULL;
+
+  struct stat info;
+  void* data = NULL;
+  if (fstat(fd, &info) == 0 && info.st_size > 0) {
+    data = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED)
+      data = NULL;
+    *size = info.st_size;
+  }
+
+  // The mapping stays valid after the file is closed.
+  close(fd);
+  return data;
+#endif
+}
+
+void system_unmap_file(const void* data, size_t size) {
+  if (!data)
+    return;
+
+#if defined(_WIN32)
+  (void)size;
+  free((void*)data);
+#else
+  munmap((void*)data, size);
+#endif
+}
+
+bool system_sync_file(FILE* file) {
+  if (fflush(file) != 0)
+    return false;
+
+#if defined(_WIN32)
+  return _commit(_fileno(file)) == 0;
+#else
+  return fsync(fileno(file)) == 0;
+#endif
+}
+
+bool system_replace_file(const char* temp_path, const char* path) {
+#if defined(_WIN32)
+  // Removing the old file and renaming would lose it if the process died in
+  // between.
+  return MoveFileExA(
+    temp_path, path, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH
+  ) != 0;
+#else
+  return rename(temp_path, path) == 0;
+#endif
+}
 
 const size_t system_tick(void) {
   return current_tick;
 }
 
+size_t system_instance(void) {
+  return system_instance_id;
+}
+
+bool system_headless(void) {
+  return system_is_headless;
+}
+
+int system_width(void) {
+  return system_is_headless ? SYSTEM_HEADLESS_WIDTH : GetRenderWidth();
+}
+
+int system_height(void) {
+  return system_is_headless ? SYSTEM_HEADLESS_HEIGHT : GetRenderHeight();
+}
+
 RenderTexture2D* system_get_framebuffer(void) {
   return &system_framebuffer;
 }
 
 int system_init(sys_args_t args) {
+  stats_init(&system_frame_times, SYSTEM_FRAME_SAMPLES);
+  stats_init(&system_lateness, SYSTEM_FRAME_SAMPLES);
+  stats_init(&system_gc_times, SYSTEM_FRAME_SAMPLES);
+  stats_init(&system_heap_sizes, SYSTEM_FRAME_SAMPLES);
+  system_deadline = system_clock();
+  system_last_present = system_deadline;
+
+  system_is_headless = args.headless;
+  system_uncapped = args.headless || args.bench_frames > 0;
+  system_instance_id = args.instance;
+  system_max_ticks = args.max_ticks;
+  if (system_is_headless)
+    return 0;
+
   // Initialize game window.
   SetTraceLogLevel(LOG_NONE);
   InitWindow(800, 600, "V-Game");
-  SetTargetFPS(60);
-  SetWindowState(FLAG_WINDOW_RESIZABLE | FLAG_VSYNC_HINT);
+  SetWindowState(FLAG_WINDOW_RESIZABLE);
+
+  // The frame pacer in `system_interrupt()` decides when frames are presented,
+  // so raylib shouldn't wait on its own.
+  SetTargetFPS(0);
 
   if (args.fullscreen) {
     int monitor = GetCurrentMonitor();
@@ -35,26 +249,153 @@ int system_init(sys_args_t args) {
   return 0;
 }
 
-void system_interrupt(void) {
-  if (WindowShouldClose() || IsKeyPressed(KEY_ESCAPE)) {
-    system_free();
-    exit(0);
+bool system_frame_skipped(void) {
+  if (system_uncapped)
+    return false;
+
+  if (system_skip_tick != current_tick) {
+    // Only skip when a whole tick behind, and never skip forever.
+    system_skip = system_clock() > system_deadline + 1.0 / SYSTEM_TICK_RATE &&
+                  system_skips_in_row < SYSTEM_MAX_FRAMESKIP;
+    system_skip_tick = current_tick;
+  }
+
+  return system_skip;
+}
+
+void system_quit(int status) {
+  if (!system_is_running)
+    return;
+
+  system_is_running = false;
+  system_status = status;
+}
+
+bool system_running(void) {
+  return system_is_running;
+}
+
+int system_exit_status(void) {
+  return system_status;
+}
+
+bool system_interrupt(void) {
+  const double step = 1.0 / SYSTEM_TICK_RATE;
+  if (!system_is_running)
+    return false;
+
+  bench_phase(BENCH_PHASE_PRESENT);
+  trace_lua_leave();
+  double trace_start = trace_begin();
+
+  if (replay_finished()) {
+    SYSTEM_LOG("Replay finished after %zu ticks.", current_tick);
+    system_quit(0);
+    return false;
+  } else if (system_is_headless) {
+    // Nothing to present, so just keep the audio engine fed and move on.
+    bench_phase(BENCH_PHASE_AUDIO);
+    audio_update(step);
+    bench_phase(BENCH_PHASE_PRESENT);
+    run_idle(system_clock());
+
+    double now = system_clock();
+    stats_push(&system_frame_times, now - system_last_present);
+    system_last_present = now;
+  } else if (WindowShouldClose() || IsKeyDown(KEY_ESCAPE)) {
+    system_quit(0);
+    return false;
+  } else if (system_frame_skipped()) {
+    system_skips_in_row++;
+    system_skipped_frames++;
+    run_idle(system_clock());
   } else {
+    system_skips_in_row = 0;
+    if (system_uncapped) {
+      run_idle(system_clock());
+    } else {
+      run_idle(system_deadline - SYSTEM_SPIN_SECONDS);
+      wait_until(system_deadline);
+    }
+
+    double present_start = system_clock();
     BeginDrawing();
     DrawTexture(system_framebuffer.texture, 0, 0, WHITE);
     EndDrawing();
 
-    if (IsWindowResized()) {
+    double present_end = system_clock();
+    latency_present(present_end);
+    stats_push(&system_lateness, present_start - system_deadline);
+    stats_push(&system_frame_times, present_end - system_last_present);
+    system_last_present = present_end;
+
+    // Compare sizes instead of using `IsWindowResized()`, since the input latch
+    // polls events too and would otherwise swallow resize notifications.
+    if (system_framebuffer.texture.width != GetRenderWidth() ||
+        system_framebuffer.texture.height != GetRenderHeight()) {
       UnloadRenderTexture(system_framebuffer);
       system_framebuffer =
         LoadRenderTexture(GetRenderWidth(), GetRenderHeight());
     }
+  }
+
+  // If the game is so far behind that skipping frames can't catch up, give up
+  // on the lost time so it doesn't try to run dozens of ticks at once later.
+  system_deadline += step;
+  if (system_uncapped ||
+      system_clock() > system_deadline + step * SYSTEM_MAX_FRAMESKIP)
+    system_deadline = system_clock() + step;
 
-    current_tick++;
+  current_tick++;
+  input_latch();
+  trace_end("system_interrupt", trace_start);
+
+  // Track the key state by hand, since the input latch makes raylib's
+  // `IsKeyPressed()` miss presses.
+  if (!system_is_headless) {
+    bool dump_key_down = IsKeyDown(TRACE_DUMP_KEY);
+    if (dump_key_down && !system_dump_key_down)
+      trace_dump();
+    system_dump_key_down = dump_key_down;
+  }
+
+  if (bench_frame() ||
+      (system_max_ticks > 0 && current_tick >= system_max_ticks)) {
+    system_quit(0);
+    return false;
   }
+  bench_phase(BENCH_PHASE_LUA);
+  trace_lua_enter();
+  return true;
+}
+
+void system_on_idle(system_idle_t callback) {
+  system_idle = callback;
+}
+
+void system_record_gc(double seconds, size_t heap) {
+  stats_push(&system_gc_times, seconds);
+  stats_push(&system_heap_sizes, (double)heap);
+}
+
+system_stats_t system_stats(void) {
+  // clang-format off
+  return (system_stats_t){
+    .frame_time = stats_summarize(&system_frame_times),
+    .lateness = stats_summarize(&system_lateness),
+    .gc_time = stats_summarize(&system_gc_times),
+    .heap_size = stats_summarize(&system_heap_sizes),
+    .skipped_frames = system_skipped_frames
+  };
+  // clang-format on
 }
 
 void system_free(void) {
+  stats_free(&system_frame_times);
+  stats_free(&system_lateness);
+  stats_free(&system_gc_times);
+  stats_free(&system_heap_sizes);
+
   if (IsRenderTextureValid(system_framebuffer))
     UnloadRenderTexture(system_framebuffer);
 
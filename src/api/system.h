@@ -9,64 +9,69 @@
 #ifndef API_SYSTEM_H
 #define API_SYSTEM_H
 
+#include "logger.h"
+#include "stats.h"
 #include <raylib.h>
 #include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <time.h>
 
-#define LOG_FMT_RESET "\x1b[0m"
-#define LOG_FMT_WARNING "\x1b[33m"
-#define LOG_FMT_ERROR "\x1b[31m"
+// How many times per second game logic runs.
+#define SYSTEM_TICK_RATE 60
+
+// The most presents that can be skipped in a row to let logic catch up.
+#define SYSTEM_MAX_FRAMESKIP 4
+
+// How close to a deadline the frame pacer stops sleeping and starts spinning.
+// OS sleeps routinely overshoot by up to a millisecond.
+#define SYSTEM_SPIN_SECONDS 0.002
+
+// The size of the screen when running without a window.
+#define SYSTEM_HEADLESS_WIDTH 800
+#define SYSTEM_HEADLESS_HEIGHT 600
+
+// How many frames of timing history the frame pacer keeps.
+#define SYSTEM_FRAME_SAMPLES 1024
 
 // clang-format off
 
 /**
-  Pretty much an alias for printf, except it inserts a '\n' character at the
-  end. Meant to be used in the Lua API as `system.log()`.
+  Logs a message, formatted like printf. Messages are written to the console by
+  a background thread, so logging never blocks the game. Meant to be used in
+  the Lua API as `system.log()`.
 */
-#define SYSTEM_LOG(...) \
-do { \
-printf(__VA_ARGS__); \
-puts(""); \
-} while (0)
-
+#define SYSTEM_LOG(...) logger_write(LOGGER_LEVEL_INFO, __VA_ARGS__)
 
 /**
-  A macro that prints out the given message in the format of a warning.
+  A macro that logs the given message in the format of a warning.
 */
-#define SYSTEM_WARN_LOG(...) \
-do { \
-  printf(LOG_FMT_WARNING "WARNING: "); \
-  printf(__VA_ARGS__); \
-  puts(LOG_FMT_RESET ""); \
-} while (0)
+#define SYSTEM_WARN_LOG(...) logger_write(LOGGER_LEVEL_WARNING, __VA_ARGS__)
 
 /**
-  A macro that prints out the given message in the format of an error message.
+  A macro that logs the given message in the format of an error message.
 */
-#define SYSTEM_ERROR_LOG(...) \
-do { \
-  printf(LOG_FMT_ERROR "ERROR: "); \
-  printf(__VA_ARGS__); \
-  puts(LOG_FMT_RESET ""); \
-} while (0)
+#define SYSTEM_ERROR_LOG(...) logger_write(LOGGER_LEVEL_ERROR, __VA_ARGS__)
 
 /**
-  A macro that prints out a message formatted as a fatal error.
+  A macro that logs a message formatted as a fatal error. Unlike other
+  messages, it's written before the macro returns.
 */
-#define SYSTEM_PANIC_LOG(...) \
-do { \
-  printf(LOG_FMT_ERROR "FATAL ERROR: "); \
-  printf(__VA_ARGS__); \
-  puts(LOG_FMT_RESET ""); \
-} while (0)
+#define SYSTEM_PANIC_LOG(...) logger_write(LOGGER_LEVEL_FATAL, __VA_ARGS__)
 
 /**
   A macro that returns the current time in unix timestamp format.
 */
 #define SYSTEM_GET_TIME() ((size_t)time(NULL))
 
+/**
+  Marks state that belongs to a single running game rather than the whole
+  process. Every thread running a game gets its own copy, which is what lets
+  the runner run many games side by side. State shared with threads the game
+  doesn't own, like the audio device's, must not use it.
+*/
+#define INSTANCE_LOCAL _Thread_local
+
 // clang-format on
 
 /**
@@ -74,13 +79,102 @@ do { \
 */
 typedef struct {
   bool fullscreen;
+  const char* record_input;
+  const char* replay_input;
+  bool latency_probe;
+  bool headless;
+  size_t bench_frames;
+  const char* trace_path;
+  logger_level_t log_level;
+  // If not 0, the game stops after this many ticks.
+  size_t max_ticks;
+  // Which instance of the game this is when the runner runs many at once,
+  // counting from 1. 0 when running a single game.
+  size_t instance;
 } sys_args_t;
 
+/**
+  Returns a monotonic timestamp in seconds with sub-microsecond precision. Only
+  differences between timestamps are meaningful.
+*/
+double system_clock(void);
+
+/**
+  Timing statistics recorded by the frame pacer.
+
+  `frame_time` is the time between consecutive presents and `lateness` is how
+  long after its deadline each present started. `gc_time` is how long garbage
+  collection took each frame. All of them are in seconds. `heap_size` is the
+  size of the Lua heap after each frame's collection, in bytes.
+*/
+typedef struct {
+  stats_summary_t frame_time, lateness, gc_time, heap_size;
+  size_t skipped_frames;
+} system_stats_t;
+
+/**
+  A function that does deferred work while the frame pacer would otherwise be
+  waiting. It should return by the given deadline, which is already past when
+  there's no time to spare.
+*/
+typedef void (*system_idle_t)(double deadline);
+
+/**
+  Maps the file at the given path into memory as read-only and stores its size
+  in `size`, so it can be read without copying. Returns NULL if the file can't
+  be opened or is empty. Where memory mapping isn't available, the file is
+  read into memory instead.
+*/
+const void* system_map_file(const char* path, size_t* size);
+
+/**
+  Unmaps a file mapped with `system_map_file()`.
+*/
+void system_unmap_file(const void* data, size_t size);
+
+/**
+  Flushes the given file and waits until its contents reach the disk. Returns
+  false if either fails.
+*/
+bool system_sync_file(FILE* file);
+
+/**
+  Replaces the file at `path` with the one at `temp_path` in a single step, so
+  `path` is never missing even if the process dies halfway. The temporary file
+  should be synced with `system_sync_file()` first. Returns false on failure.
+*/
+bool system_replace_file(const char* temp_path, const char* path);
+
 /**
   Returns the system tick (how many interrupts have been executed).
 */
 const size_t system_tick(void);
 
+/**
+  Returns which instance of the game this is when the runner runs many at
+  once, counting from 1. Returns 0 when running a single game.
+*/
+size_t system_instance(void);
+
+/**
+  Returns true if the runtime was started without a window or audio device.
+
+  Headless runtimes still run every interrupt and process every graphics and
+  audio command, but present nothing and never wait, so games run as fast as
+  the CPU allows.
+*/
+bool system_headless(void);
+
+/**
+  Returns the width of the screen in pixels.
+*/
+int system_width(void);
+
+/**
+  Returns the height of the screen in pixels.
+*/
+int system_height(void);
+
 /**
   Returns the system framebuffer.
 */
@@ -92,10 +186,59 @@ RenderTexture2D* system_get_framebuffer(void);
 int system_init(sys_args_t args);
 
 /**
-  Causes the system to interrupt. During an interrupt, the swap chain swaps
-  buffers, the input refreshes, and the current tick is incremented.
+  Returns true if the current frame won't be presented because logic has
+  fallen behind and the frame pacer is skipping frames to catch up. Drawing
+  can be skipped for such frames, but state changes should still be applied.
+*/
+bool system_frame_skipped(void);
+
+/**
+  Asks the runtime to stop with the given exit status. Nothing is torn down
+  right away; instead every interrupt from then on returns false so callers can
+  unwind back to the entry point. Only the first request counts.
+*/
+void system_quit(int status);
+
+/**
+  Returns true until `system_quit()` is called.
+*/
+bool system_running(void);
+
+/**
+  Returns the exit status given to `system_quit()`.
+*/
+int system_exit_status(void);
+
+/**
+  Causes the system to interrupt. During an interrupt, the frame pacer waits
+  until the next tick is due, the swap chain swaps buffers, the current tick is
+  incremented, and the input is latched right before returning.
+
+  Logic runs at a fixed `SYSTEM_TICK_RATE` no matter the refresh rate of the
+  monitor. If logic falls behind, up to `SYSTEM_MAX_FRAMESKIP` presents in a
+  row are skipped to catch up. Past that, the game slows down instead.
+
+  Returns false once the runtime should stop, either because the window was
+  closed, a replay or benchmark finished, or `system_quit()` was called.
+*/
+bool system_interrupt(void);
+
+/**
+  Sets the function called once per interrupt with the time left before the
+  next present. Pass NULL to remove it.
+*/
+void system_on_idle(system_idle_t callback);
+
+/**
+  Records how long garbage collection took this frame and how large the heap
+  was afterwards, in bytes.
+*/
+void system_record_gc(double seconds, size_t heap);
+
+/**
+  Summarizes the timing of recent frames.
 */
-void system_interrupt(void);
+system_stats_t system_stats(void);
 
 /**
   Deletes the system window along with all resources related to it.
@@ -0,0 +1,177 @@
+/**
+  src/api/trace.c
+
+  Written by DoelJavid for V-GAME.
+
+  https://github.com/DoelJavid/v-game
+*/
+
+#include "trace.h"
+
+/**
+  A single complete span. `sequence` is written last so a dump can tell when a
+  slot has been fully written.
+*/
+typedef struct {
+  const char* name;
+  double start, duration;
+  int thread;
+  atomic_size_t sequence;
+} trace_event_t;
+
+// Read by the audio thread, so it's atomic.
+static atomic_bool trace_running = false;
+static char* trace_path = NULL;
+static double trace_epoch = 0.0;
+static double trace_lua_start = -1.0;
+
+static trace_event_t* trace_events = NULL;
+static atomic_size_t trace_next = 0;
+
+static char* trace_names[TRACE_MAX_NAMES];
+static size_t trace_name_count = 0;
+
+static atomic_int trace_thread_count = 0;
+static _Thread_local int trace_thread = 0;
+
+void trace_init(const char* path) {
+  trace_events = calloc(TRACE_CAPACITY, sizeof(trace_event_t));
+  trace_path = malloc(strlen(path) + 1);
+  if (!trace_events || !trace_path) {
+    SYSTEM_ERROR_LOG("Failed to start tracing!");
+    free(trace_events);
+    free(trace_path);
+    trace_events = NULL;
+    trace_path = NULL;
+    return;
+  }
+
+  strcpy(trace_path, path);
+  trace_epoch = system_clock();
+  trace_running = true;
+  SYSTEM_LOG("Tracing to %s (press F9 to dump)", path);
+}
+
+bool trace_active(void) {
+  return trace_running;
+}
+
+double trace_begin(void) {
+  return trace_running ? system_clock() : 0.0;
+}
+
+void trace_end(const char* name, double start) {
+  if (!trace_running || !name)
+    return;
+
+  if (trace_thread == 0)
+    trace_thread = atomic_fetch_add(&trace_thread_count, 1) + 1;
+
+  size_t index = atomic_fetch_add_explicit(&trace_next, 1, memory_order_relaxed);
+  trace_event_t* event = &trace_events[index & (TRACE_CAPACITY - 1)];
+
+  // Mark the slot as being written before touching it.
+  atomic_store_explicit(&event->sequence, 0, memory_order_relaxed);
+  event->name = name;
+  event->start = start;
+  event->duration = system_clock() - start;
+  event->thread = trace_thread;
+  atomic_store_explicit(&event->sequence, index + 1, memory_order_release);
+}
+
+const char* trace_intern(const char* name) {
+  for (size_t i = 0; i < trace_name_count; i++)
+    if (strcmp(trace_names[i], name) == 0)
+      return trace_names[i];
+
+  if (trace_name_count == TRACE_MAX_NAMES)
+    return NULL;
+
+  char* copy = malloc(strlen(name) + 1);
+  if (!copy)
+    return NULL;
+
+  strcpy(copy, name);
+  trace_names[trace_name_count++] = copy;
+  return copy;
+}
+
+void trace_lua_enter(void) {
+  trace_lua_start = trace_begin();
+}
+
+void trace_lua_leave(void) {
+  if (trace_lua_start < 0.0)
+    return;
+
+  trace_end("lua", trace_lua_start);
+  trace_lua_start = -1.0;
+}
+
+/**
+  Writes the given string as a JSON string literal.
+*/
+static void write_json_string(FILE* file, const char* str) {
+  fputc('"', file);
+  for (; *str; str++) {
+    if (*str == '"' || *str == '\\')
+      fputc('\\', file);
+    if ((unsigned char)*str >= 0x20)
+      fputc(*str, file);
+  }
+  fputc('"', file);
+}
+
+void trace_dump(void) {
+  if (!trace_running)
+    return;
+
+  FILE* file = fopen(trace_path, "w");
+  if (!file) {
+    SYSTEM_ERROR_LOG("Failed to write trace to \"%s\"!", trace_path);
+    return;
+  }
+
+  size_t end = atomic_load_explicit(&trace_next, memory_order_acquire);
+  size_t begin = end > TRACE_CAPACITY ? end - TRACE_CAPACITY : 0;
+  bool first = true;
+
+  fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+  for (size_t i = begin; i < end; i++) {
+    trace_event_t* event = &trace_events[i & (TRACE_CAPACITY - 1)];
+    if (atomic_load_explicit(&event->sequence, memory_order_acquire) != i + 1)
+      continue;
+
+    fprintf(file, first ? "{\"name\":" : ",\n{\"name\":");
+    write_json_string(file, event->name);
+    fprintf(
+      file, ",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+      event->thread, (event->start - trace_epoch) * 1e6,
+      event->duration * 1e6
+    );
+    first = false;
+  }
+  fprintf(file, "\n]}\n");
+
+  fclose(file);
+  SYSTEM_LOG("Wrote %zu trace events to %s", end - begin, trace_path);
+}
+
+void trace_free(void) {
+  if (!trace_running)
+    return;
+
+  trace_dump();
+  atomic_store(&trace_running, false);
+
+  // The audio thread is the only other one tracing, and it's stopped before
+  // this is called, so nothing can still be writing events.
+  free(trace_events);
+  trace_events = NULL;
+  atomic_store(&trace_next, 0);
+  for (size_t i = 0; i < trace_name_count; i++)
+    free(trace_names[i]);
+  trace_name_count = 0;
+  free(trace_path);
+  trace_path = NULL;
+}
@@ -0,0 +1,80 @@
+/**
+  src/api/trace.h
+
+  Written by DoelJavid for V-GAME.
+
+  https://github.com/DoelJavid/v-game
+*/
+
+#ifndef API_TRACE_H
+#define API_TRACE_H
+
+#include "system.h"
+#include <stdatomic.h>
+#include <stdint.h>
+#include <string.h>
+
+// How many events the trace ring holds. Must be a power of two. Once full, the
+// oldest events are overwritten.
+#define TRACE_CAPACITY 65536
+
+// How many distinct zone names Lua can create.
+#define TRACE_MAX_NAMES 256
+
+// The key that dumps the trace while the game is running.
+#define TRACE_DUMP_KEY KEY_F9
+
+/**
+  Starts recording trace events. They're written to the given path as Chrome
+  trace-event JSON when tracing stops or when `TRACE_DUMP_KEY` is pressed. The
+  file can be opened with chrome://tracing or Perfetto.
+*/
+void trace_init(const char* path);
+
+/**
+  Returns true while tracing.
+*/
+bool trace_active(void);
+
+/**
+  Returns the start time of a span, to be passed to `trace_end()` later. Cheap
+  enough to leave in hot paths when tracing is off.
+*/
+double trace_begin(void);
+
+/**
+  Records a span with the given name that started at the given time and ends
+  now. The name must stay valid until tracing stops. Safe to call from any
+  thread.
+*/
+void trace_end(const char* name, double start);
+
+/**
+  Returns a copy of the given name that stays valid until tracing stops, for
+  names that come from Lua. Returns NULL if too many names have been interned.
+*/
+const char* trace_intern(const char* name);
+
+/**
+  Marks control passing to Lua. The time until `trace_lua_leave()` is recorded
+  as a `lua` span.
+*/
+void trace_lua_enter(void);
+
+/**
+  Marks control coming back from Lua into the runtime.
+*/
+void trace_lua_leave(void);
+
+/**
+  Writes every recorded event to the trace file.
+*/
+void trace_dump(void);
+
+/**
+  Dumps the trace one last time and stops tracing. Must be called once no other
+  thread can record events, so after `audio_free()`.
+*/
+void trace_free(void);
+
+#endif
@@ -8,6 +8,11 @@
 
 #include "audio.h"
 
+/**
+  Plays a sound on the given channel. Channels 1 to 4 play their own waveform
+  by default, and every channel after that cycles through the same four
+  waveforms unless the info table has a `Waveform` field.
+*/
 static int luaaudio_blip(lua_State* L) {
   int channel = luaL_checkint(L, 1);
 
@@ -15,13 +20,61 @@ static int luaaudio_blip(lua_State* L) {
   lua_getfield(L, 2, "Semitone");
   lua_getfield(L, 2, "Volume");
   lua_getfield(L, 2, "Duration");
+  lua_getfield(L, 2, "Pan");
+  lua_getfield(L, 2, "Waveform");
+
+  // clang-format off
+  waveform_params_t params = {
+    .semitone = luaL_optint(L, -5, 3),
+    .volume = luaL_optnumber(L, -4, 0.5f),
+    .duration = luaL_optnumber(L, -3, 0.2f),
+    .pan = luaL_optnumber(L, -2, 0.0f),
+    .type = luaL_optint(L, -1, (channel - 1) % 4 + 1)
+  };
+  // clang-format on
+
+  lua_pop(L, 5);
+  audio_play(channel, params);
+  return 0;
+}
 
-  int semitone = luaL_optint(L, -3, 3);
-  float volume = luaL_optnumber(L, -2, 0.5f);
-  float duration = luaL_optnumber(L, -1, 0.2f);
+/**
+  Stops the sound playing on the given channel.
+*/
+static int luaaudio_stop(lua_State* L) {
+  audio_stop(luaL_checkint(L, 1));
+  return 0;
+}
+
+/**
+  Changes the semitone, volume and/or pan of the sound playing on the given
+  channel without restarting it. Fields missing from the info table are left
+  alone.
+*/
+static int luaaudio_set(lua_State* L) {
+  int channel = luaL_checkint(L, 1);
+
+  luaL_checktype(L, 2, LUA_TTABLE);
+  lua_getfield(L, 2, "Semitone");
+  lua_getfield(L, 2, "Volume");
+  lua_getfield(L, 2, "Pan");
+
+  if (!lua_isnil(L, -3))
+    audio_set(channel, AUDIO_PARAM_SEMITONE, luaL_checkint(L, -3));
+  if (!lua_isnil(L, -2))
+    audio_set(channel, AUDIO_PARAM_VOLUME, luaL_checknumber(L, -2));
+  if (!lua_isnil(L, -1))
+    audio_set(channel, AUDIO_PARAM_PAN, luaL_checknumber(L, -1));
 
   lua_pop(L, 3);
-  audio_blip(channel, semitone, volume, duration);
+  return 0;
+}
+
+/**
+  Sets the volume of everything played, after every channel is mixed together.
+*/
+static int luaaudio_master(lua_State* L) {
+  audio_master(luaL_checknumber(L, 1));
   return 0;
 }
 
@@ -29,6 +82,9 @@ void luaopen_audio(lua_State* L) {
   // clang-format off
   static const luaL_Reg luaaudio_lib[] = {
     {"blip", luaaudio_blip},
+    {"stop", luaaudio_stop},
+    {"set", luaaudio_set},
+    {"master", luaaudio_master},
     {NULL, NULL}
   };
   // clang-format on
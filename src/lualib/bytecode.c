@@ -0,0 +1,228 @@
+/**
+  src/lualib/bytecode.c
+
+  Written by DoelJavid for V-GAME.
+
+  https://github.com/DoelJavid/v-game
+*/
+
+#include "bytecode.h"
+
+/**
+  The start of every cache file. Compared as a whole against the header the
+  current source and runtime would produce.
+*/
+typedef struct {
+  char magic[4];
+  uint32_t version;
+  uint64_t runtime;
+  uint64_t source_hash;
+  uint64_t source_length;
+} bytecode_header_t;
+
+/**
+  A growing buffer that `lua_dump()` writes into.
+*/
+typedef struct {
+  char* data;
+  size_t length, capacity;
+} bytecode_buffer_t;
+
+/**
+  FNV-1a hash of the given data, continuing from the given hash.
+*/
+static uint64_t hash_data(uint64_t hash, const char* data, size_t length) {
+  for (size_t i = 0; i < length; i++) {
+    hash ^= (unsigned char)data[i];
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+/**
+  Returns a hash identifying this build of the runtime. Bytecode isn't portable
+  between Lua builds, so any rebuild invalidates the cache.
+*/
+static uint64_t runtime_hash(void) {
+  const char* build = __DATE__ " " __TIME__ " " LUA_VERSION;
+  uint64_t hash = hash_data(14695981039346656037ULL, build, strlen(build));
+  return hash ^ sizeof(void*);
+}
+
+/**
+  Reads an entire file into memory. Returns NULL if it can't be read.
+*/
+static char* read_file(const char* path, size_t* length) {
+  FILE* file = fopen(path, "rb");
+  if (!file)
+    return NULL;
+
+  char* data = NULL;
+  long size;
+  if (fseek(file, 0, SEEK_END) == 0 && (size = ftell(file)) >= 0 &&
+      fseek(file, 0, SEEK_SET) == 0 && (data = malloc(size ? size : 1))) {
+    if (fread(data, 1, size, file) != (size_t)size) {
+      free(data);
+      data = NULL;
+    }
+    *length = size;
+  }
+
+  fclose(file);
+  return data;
+}
+
+/**
+  Writes the path of the cache for the given source into `cache_path`. Returns
+  false if it doesn't fit.
+*/
+static bool get_cache_path(const char* path, char* cache_path, size_t size) {
+  size_t length = strlen(path);
+  if (length >= 4 && strcmp(&path[length - 4], ".lua") == 0)
+    length -= 4;
+
+  int written = snprintf(
+    cache_path, size, "%.*s" BYTECODE_CACHE_EXTENSION, (int)length, path
+  );
+  return written >= 0 && (size_t)written < size;
+}
+
+/**
+  A `lua_Writer` that appends to a `bytecode_buffer_t`.
+*/
+static int write_buffer(lua_State* L, const void* p, size_t sz, void* ud) {
+  (void)L;
+  bytecode_buffer_t* buffer = ud;
+  if (buffer->length + sz > buffer->capacity) {
+    size_t capacity = buffer->capacity ? buffer->capacity * 2 : 4096;
+    while (capacity < buffer->length + sz)
+      capacity *= 2;
+
+    char* data = realloc(buffer->data, capacity);
+    if (!data)
+      return 1;
+    buffer->data = data;
+    buffer->capacity = capacity;
+  }
+
+  memcpy(&buffer->data[buffer->length], p, sz);
+  buffer->length += sz;
+  return 0;
+}
+
+/**
+  Writes the function on top of the stack to the cache. The cache is written to
+  a temporary file first and then renamed, so an interrupted write never
+  leaves a broken cache behind.
+*/
+static void write_cache(
+  lua_State* L, const char* cache_path, const bytecode_header_t* header
+) {
+  size_t length;
+  char* data = bytecode_dump(L, &length);
+  if (!data)
+    return;
+
+  // Instances started by the runner may write the same cache at once, so each
+  // writes its own temporary file.
+  char temp_path[4096];
+  snprintf(
+    temp_path, sizeof(temp_path), "%s.%zu.tmp", cache_path, system_instance()
+  );
+
+  FILE* file = fopen(temp_path, "wb");
+  bool written = file &&
+                 fwrite(header, sizeof(bytecode_header_t), 1, file) == 1 &&
+                 fwrite(data, 1, length, file) == length &&
+                 system_sync_file(file);
+  if (file && fclose(file) != 0)
+    written = false;
+  free(data);
+
+  if (!written || !system_replace_file(temp_path, cache_path)) {
+    remove(temp_path);
+    SYSTEM_WARN_LOG("Failed to write bytecode cache \"%s\"!", cache_path);
+  }
+}
+
+char* bytecode_dump(lua_State* L, size_t* length) {
+  bytecode_buffer_t buffer = {0};
+  if (lua_dump(L, write_buffer, &buffer) != 0 || !buffer.data) {
+    free(buffer.data);
+    return NULL;
+  }
+
+  *length = buffer.length;
+  return buffer.data;
+}
+
+int bytecode_load(lua_State* L, const char* path) {
+  double start = system_clock();
+
+  size_t source_length;
+  char* source = read_file(path, &source_length);
+  if (!source)
+    return luaL_loadfile(L, path);
+
+  char chunk_name[4096];
+  snprintf(chunk_name, sizeof(chunk_name), "@%s", path);
+
+  bytecode_header_t header = {
+    .magic = {'V', 'G', 'B', 'C'},
+    .version = BYTECODE_CACHE_VERSION,
+    .runtime = runtime_hash(),
+    .source_hash =
+      hash_data(14695981039346656037ULL, source, source_length),
+    .source_length = source_length
+  };
+
+  char cache_path[4096];
+  bool cacheable = get_cache_path(path, cache_path, sizeof(cache_path));
+
+  size_t cache_length;
+  char* cache = cacheable ? read_file(cache_path, &cache_length) : NULL;
+  if (cache && cache_length > sizeof(header) &&
+      memcmp(cache, &header, sizeof(header)) == 0) {
+    int status = luaL_loadbuffer(
+      L, &cache[sizeof(header)], cache_length - sizeof(header), chunk_name
+    );
+    free(cache);
+
+    if (status == 0) {
+      free(source);
+      SYSTEM_LOG(
+        "Loaded %s from cache in %.2fms", path, (system_clock() - start) * 1000
+      );
+      return 0;
+    }
+
+    // A corrupt cache is rebuilt from source below.
+    lua_pop(L, 1);
+  } else {
+    free(cache);
+  }
+
+  // Skip a leading shebang line like `luaL_loadfile()` does, keeping the
+  // newline so line numbers stay the same.
+  size_t offset = 0;
+  if (source_length > 0 && source[0] == '#')
+    while (offset < source_length && source[offset] != '\n')
+      offset++;
+
+  int status = luaL_loadbuffer(
+    L, &source[offset], source_length - offset, chunk_name
+  );
+  free(source);
+  if (status != 0)
+    return status;
+
+  double compiled = system_clock();
+  if (cacheable)
+    write_cache(L, cache_path, &header);
+
+  SYSTEM_LOG(
+    "Compiled %s in %.2fms (cached in %.2fms)", path,
+    (compiled - start) * 1000, (system_clock() - compiled) * 1000
+  );
+  return 0;
+}
@@ -0,0 +1,42 @@
+/**
+  src/lualib/bytecode.h
+
+  Written by DoelJavid for V-GAME.
+
+  https://github.com/DoelJavid/v-game
+*/
+
+#ifndef LUALIB_BYTECODE_H
+#define LUALIB_BYTECODE_H
+
+#include "../api/system.h"
+#include <lauxlib.h>
+#include <lua.h>
+#include <stdint.h>
+#include <string.h>
+
+// Bump this whenever a change to the runtime makes old caches unusable in a
+// way a rebuild alone wouldn't catch.
+#define BYTECODE_CACHE_VERSION 1
+
+// The extension given to cache files, which replaces `.lua`.
+#define BYTECODE_CACHE_EXTENSION ".vbc"
+
+/**
+  Loads the Lua file at the given path as a function on top of the stack, just
+  like `luaL_loadfile()`.
+
+  The compiled bytecode is cached in a `.vbc` file next to the source. The
+  cache is keyed by a hash of the source and is only used if it was written by
+  this exact build of the runtime, so it never has to be cleared by hand.
+*/
+int bytecode_load(lua_State* L, const char* path);
+
+/**
+  Dumps the function on top of the stack as bytecode into a newly allocated
+  buffer and stores its length in `length`. Returns NULL on failure. The buffer
+  must be freed with `free()`.
+*/
+char* bytecode_dump(lua_State* L, size_t* length);
+
+#endif
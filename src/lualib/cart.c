@@ -0,0 +1,505 @@
+/**
+  src/lualib/cart.c
+
+  Written by DoelJavid for V-GAME.
+
+  https://github.com/DoelJavid/v-game
+*/
+
+#include "cart.h"
+
+// The directory modules are loaded from when not running a cartridge,
+// including the trailing separator.
+static INSTANCE_LOCAL char* luacart_root = NULL;
+
+// Marks a module that's still being imported, to catch import loops.
+static char luacart_loading;
+
+/**
+  The state of a `lua_Reader` that hands over a whole blob in one go.
+*/
+typedef struct {
+  const char* data;
+  size_t length;
+} blob_reader_t;
+
+/**
+  A `lua_Reader` that returns the entire blob the first time it's called.
+*/
+static const char* read_blob(lua_State* L, void* ud, size_t* size) {
+  (void)L;
+  blob_reader_t* reader = ud;
+  if (reader->length == 0)
+    return NULL;
+
+  *size = reader->length;
+  reader->length = 0;
+  return reader->data;
+}
+
+/**
+  Returns true if the given string ends with the given suffix.
+*/
+static bool ends_with(const char* str, const char* suffix) {
+  size_t length = strlen(str), suffix_length = strlen(suffix);
+  return length >= suffix_length &&
+         strcmp(&str[length - suffix_length], suffix) == 0;
+}
+
+/**
+  Returns the length of the directory part of the given path, including the
+  trailing separator.
+*/
+static size_t directory_length(const char* path) {
+  size_t length = strlen(path);
+  while (length > 0 && path[length - 1] != '/' && path[length - 1] != '\\')
+    length--;
+  return length;
+}
+
+bool luacart_init(const char* path) {
+  if (ends_with(path, CART_EXTENSION))
+    return cart_open(path);
+
+  size_t length = directory_length(path);
+  free(luacart_root);
+  if (!(luacart_root = malloc(length + 1)))
+    return false;
+
+  memcpy(luacart_root, path, length);
+  luacart_root[length] = '\0';
+  return true;
+}
+
+int luacart_load(lua_State* L, const char* name) {
+  if (!cart_loaded()) {
+    size_t length = strlen(luacart_root) + strlen(name) + sizeof(".lua");
+    char* path = malloc(length);
+    if (!path) {
+      lua_pushliteral(L, "not enough memory");
+      return LUA_ERRMEM;
+    }
+
+    snprintf(path, length, "%s%s.lua", luacart_root, name);
+    int status = bytecode_load(L, path);
+    free(path);
+    return status;
+  }
+
+  cart_blob_t blob;
+  if (!cart_find(name, &blob) ||
+      (blob.type != CART_BLOB_SCRIPT && blob.type != CART_BLOB_BYTECODE)) {
+    lua_pushfstring(L, "module '%s' not found in cartridge", name);
+    return LUA_ERRFILE;
+  }
+
+  lua_pushfstring(L, "@%s.lua", name);
+  blob_reader_t reader = {.data = blob.data, .length = blob.length};
+  int status = lua_load(L, read_blob, &reader, lua_tostring(L, -1));
+  lua_remove(L, -2);
+  return status;
+}
+
+/**
+  Runs the module with the given name and returns whatever it returns. Each
+  module only runs once, and importing it again returns the same value.
+*/
+static int luacart_import(lua_State* L) {
+  const char* name = luaL_checkstring(L, 1);
+  lua_settop(L, 1);
+  lua_getfield(L, LUA_REGISTRYINDEX, LUACART_IMPORTED);
+
+  lua_getfield(L, 2, name);
+  if (lua_touserdata(L, -1) == &luacart_loading)
+    return luaL_error(L, "module '%s' imports itself", name);
+  if (!lua_isnil(L, -1))
+    return 1;
+  lua_pop(L, 1);
+
+  if (luacart_load(L, name) != 0)
+    return lua_error(L);
+
+  lua_pushlightuserdata(L, &luacart_loading);
+  lua_setfield(L, 2, name);
+
+  // A module that throws can be imported again, so it's no longer marked as
+  // loading. The error is rethrown as-is, which keeps `system.exit()` working.
+  lua_pushvalue(L, 1);
+  if (lua_pcall(L, 1, 1, 0) != 0) {
+    lua_pushnil(L);
+    lua_setfield(L, 2, name);
+    return lua_error(L);
+  }
+  if (lua_isnil(L, -1)) {
+    lua_pop(L, 1);
+    lua_pushboolean(L, 1);
+  }
+
+  lua_pushvalue(L, -1);
+  lua_setfield(L, 2, name);
+  return 1;
+}
+
+/**
+  A growable list of module names, each allocated with `malloc()`.
+*/
+typedef struct {
+  char** names;
+  size_t count;
+  size_t capacity;
+} module_list_t;
+
+/**
+  Returns true if the list has the given module.
+*/
+static bool module_list_has(const module_list_t* list, const char* name) {
+  for (size_t i = 0; i < list->count; i++)
+    if (strcmp(list->names[i], name) == 0)
+      return true;
+  return false;
+}
+
+/**
+  Adds a copy of the first `length` bytes of `name` to the list, unless it's
+  already there. Returns false if out of memory.
+*/
+static bool module_list_add(
+  module_list_t* list, const char* name, size_t length
+) {
+  char* copy = malloc(length + 1);
+  if (!copy)
+    return false;
+  memcpy(copy, name, length);
+  copy[length] = '\0';
+
+  if (module_list_has(list, copy)) {
+    free(copy);
+    return true;
+  }
+
+  if (list->count == list->capacity) {
+    size_t capacity = list->capacity ? list->capacity * 2 : 16;
+    char** names = realloc(list->names, capacity * sizeof(char*));
+    if (!names) {
+      free(copy);
+      return false;
+    }
+    list->names = names;
+    list->capacity = capacity;
+  }
+
+  list->names[list->count++] = copy;
+  return true;
+}
+
+/**
+  Frees every name in the list, along with the list itself.
+*/
+static void module_list_free(module_list_t* list) {
+  for (size_t i = 0; i < list->count; i++)
+    free(list->names[i]);
+  free(list->names);
+}
+
+/**
+  Returns true if the given character can be part of a Lua name.
+*/
+static bool is_name_char(char c) {
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+         (c >= '0' && c <= '9') || c == '_';
+}
+
+/**
+  Returns the offset just past the long bracket opening at `i`, like `[[` or
+  `[==[`, and stores its level in `level`. Returns `i` if there isn't one.
+*/
+static size_t long_bracket(
+  const char* source, size_t length, size_t i, size_t* level
+) {
+  if (i >= length || source[i] != '[')
+    return i;
+
+  size_t j = i + 1;
+  while (j < length && source[j] == '=')
+    j++;
+  if (j >= length || source[j] != '[')
+    return i;
+
+  *level = j - i - 1;
+  return j + 1;
+}
+
+/**
+  Returns the offset just past the long bracket closing `level`, starting the
+  search at `i`.
+*/
+static size_t skip_long_string(
+  const char* source, size_t length, size_t i, size_t level
+) {
+  for (; i < length; i++) {
+    if (source[i] != ']')
+      continue;
+
+    size_t j = i + 1;
+    while (j < length && source[j] == '=')
+      j++;
+    if (j < length && source[j] == ']' && j - i - 1 == level)
+      return j + 1;
+  }
+  return length;
+}
+
+/**
+  Adds every module the given source imports by a literal name, like
+  `import("enemies/boss")`, to the list. Comments and strings are skipped.
+  Returns false if the source uses `import` any other way, since the modules
+  it needs can't be known ahead of time. Sets `*failed` if out of memory.
+*/
+static bool find_imports(
+  const char* source, size_t length, module_list_t* list, bool* failed
+) {
+  bool literal_only = true;
+  size_t i = 0;
+
+  while (i < length) {
+    char c = source[i];
+    size_t start, level;
+
+    if (c == '-' && i + 1 < length && source[i + 1] == '-') {
+      // Comments, which may be long comments.
+      i += 2;
+      if ((start = long_bracket(source, length, i, &level)) != i) {
+        i = skip_long_string(source, length, start, level);
+      } else {
+        while (i < length && source[i] != '\n')
+          i++;
+      }
+    } else if (c == '[' &&
+               (start = long_bracket(source, length, i, &level)) != i) {
+      i = skip_long_string(source, length, start, level);
+    } else if (c == '"' || c == '\'') {
+      for (i++; i < length && source[i] != c && source[i] != '\n'; i++)
+        if (source[i] == '\\')
+          i++;
+      i++;
+    } else if (is_name_char(c)) {
+      // Names, skipped whole so only `import` itself matches, and not fields
+      // or methods named `import`.
+      start = i;
+      while (i < length && is_name_char(source[i]))
+        i++;
+
+      bool field = start > 0 && (source[start - 1] == '.' ||
+                                 source[start - 1] == ':');
+      if (field || i - start != 6 || strncmp(&source[start], "import", 6) != 0)
+        continue;
+
+      size_t j = i;
+      while (j < length && (source[j] == ' ' || source[j] == '\t'))
+        j++;
+      if (j < length && source[j] == '(') {
+        j++;
+        while (j < length && (source[j] == ' ' || source[j] == '\t'))
+          j++;
+      }
+
+      // Only plain string literals name a module that can be packed.
+      char quote = j < length ? source[j] : '\0';
+      size_t end = j + 1;
+      if (quote == '"' || quote == '\'') {
+        while (end < length && source[end] != quote &&
+               source[end] != '\\' && source[end] != '\n')
+          end++;
+      }
+
+      if ((quote == '"' || quote == '\'') && end < length &&
+          source[end] == quote) {
+        if (!module_list_add(list, &source[j + 1], end - j - 1))
+          *failed = true;
+        i = end + 1;
+      } else {
+        literal_only = false;
+      }
+    } else {
+      i++;
+    }
+  }
+
+  return literal_only;
+}
+
+/**
+  Finds every module the game at `entry` needs, starting with the game itself
+  as `LUACART_ENTRY`. Returns false if any of them imports a module by a name
+  it computes, in which case every script has to be packed.
+*/
+static bool find_modules(
+  const char* root, const char* entry, module_list_t* list, bool* failed
+) {
+  bool literal_only = true;
+  if (!module_list_add(list, LUACART_ENTRY, strlen(LUACART_ENTRY))) {
+    *failed = true;
+    return true;
+  }
+
+  for (size_t i = 0; i < list->count && !*failed; i++) {
+    char path[4096];
+    if (i == 0)
+      snprintf(path, sizeof(path), "%s", entry);
+    else
+      snprintf(path, sizeof(path), "%s/%s.lua", root, list->names[i]);
+
+    size_t length = 0;
+    const char* source = system_map_file(path, &length);
+    if (!source)
+      continue;
+
+    if (!find_imports(source, length, list, failed))
+      literal_only = false;
+    system_unmap_file(source, length);
+  }
+
+  return literal_only;
+}
+
+int luacart_pack(const char* path, const char* output) {
+  size_t root_length = directory_length(path);
+  char* root = malloc(root_length + 2);
+  if (!root)
+    return 1;
+
+  if (root_length == 0) {
+    strcpy(root, ".");
+  } else {
+    memcpy(root, path, root_length - 1);
+    root[root_length - 1] = '\0';
+  }
+
+  // Only the scripts the game imports are packed, unless it computes the
+  // names of the modules it imports.
+  module_list_t modules = {0};
+  bool failed = false;
+  bool pack_all = !find_modules(root, path, &modules, &failed);
+  if (pack_all)
+    SYSTEM_WARN_LOG(
+      "The game imports modules by computed names, packing every script."
+    );
+
+  lua_State* L = luaL_newstate();
+  FilePathList files = LoadDirectoryFilesEx(root, NULL, true);
+  cart_blob_t* blobs = calloc(files.count + 1, sizeof(cart_blob_t));
+  size_t count = 0;
+  int status = !L || !blobs || failed;
+
+  for (unsigned int i = 0; !status && i < files.count; i++) {
+    const char* file = files.paths[i];
+    if (ends_with(file, BYTECODE_CACHE_EXTENSION) ||
+        ends_with(file, CART_EXTENSION) || ends_with(file, STORAGE_EXTENSION) ||
+        ends_with(file, ".tmp"))
+      continue;
+
+    // Names are relative to the game's directory and always use '/'.
+    size_t offset = strlen(root) + 1;
+    if (strncmp(file, root, strlen(root)) != 0 || strlen(file) <= offset)
+      continue;
+
+    char* name = malloc(strlen(file) + 1);
+    if (!name) {
+      status = 1;
+      break;
+    }
+    strcpy(name, &file[offset]);
+    for (char* c = name; *c; c++)
+      if (*c == '\\')
+        *c = '/';
+
+    cart_blob_t* blob = &blobs[count];
+    blob->name = name;
+
+    if (ends_with(name, ".lua")) {
+      bool entry = strcmp(&file[offset], &path[root_length]) == 0;
+      name[strlen(name) - 4] = '\0';
+      if (entry) {
+        strcpy(name, LUACART_ENTRY);
+      } else if (strcmp(name, LUACART_ENTRY) == 0) {
+        SYSTEM_WARN_LOG("Skipping %s, it clashes with the game itself.", file);
+        free(name);
+        continue;
+      }
+
+      bool needed = module_list_has(&modules, name);
+      if (!needed && !pack_all) {
+        free(name);
+        continue;
+      }
+
+      // Scripts the game may not even import don't stop it from being packed.
+      if (luaL_loadfile(L, file) != 0) {
+        if (!needed) {
+          SYSTEM_WARN_LOG("Skipping %s", lua_tostring(L, -1));
+          lua_pop(L, 1);
+          free(name);
+          continue;
+        }
+
+        SYSTEM_ERROR_LOG("%s", lua_tostring(L, -1));
+        free(name);
+        status = 1;
+        break;
+      }
+
+      blob->type = CART_BLOB_BYTECODE;
+      blob->data = bytecode_dump(L, &blob->length);
+      lua_pop(L, 1);
+    } else {
+      int length = 0;
+      blob->type = CART_BLOB_DATA;
+      blob->data = LoadFileData(file, &length);
+      blob->length = length;
+    }
+
+    if (!blob->data) {
+      SYSTEM_ERROR_LOG("Failed to read %s!", file);
+      free(name);
+      status = 1;
+      break;
+    }
+
+    count++;
+  }
+
+  if (!status)
+    status = !cart_write(output, blobs, count);
+  if (!status)
+    SYSTEM_LOG("Packed %zu files into %s", count, output);
+
+  for (size_t i = 0; i < count; i++) {
+    free((char*)blobs[i].name);
+    if (blobs[i].type == CART_BLOB_DATA)
+      UnloadFileData((unsigned char*)blobs[i].data);
+    else
+      free((void*)blobs[i].data);
+  }
+
+  free(blobs);
+  module_list_free(&modules);
+  UnloadDirectoryFiles(files);
+  if (L)
+    lua_close(L);
+  free(root);
+  return status;
+}
+
+void luaopen_cart(lua_State* L) {
+  lua_newtable(L);
+  lua_setfield(L, LUA_REGISTRYINDEX, LUACART_IMPORTED);
+
+  lua_pushcfunction(L, luacart_import);
+  lua_setglobal(L, "import");
+}
+
+void luacart_free(void) {
+  cart_close();
+  free(luacart_root);
+  luacart_root = NULL;
+}
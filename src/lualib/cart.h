@@ -0,0 +1,60 @@
+/**
+  src/lualib/cart.h
+
+  Written by DoelJavid for V-GAME.
+
+  https://github.com/DoelJavid/v-game
+*/
+
+#ifndef LUALIB_CART_H
+#define LUALIB_CART_H
+
+#include "../api/cart.h"
+#include "../api/storage.h"
+#include "bytecode.h"
+#include <lauxlib.h>
+#include <lua.h>
+
+// The name of the script that starts a cartridge.
+#define LUACART_ENTRY "init"
+
+// The registry field holding every module loaded by `import()`.
+#define LUACART_IMPORTED "vgame.imported"
+
+/**
+  Sets up where games are loaded from. If the given path is a cartridge, it's
+  mapped into memory and every module is loaded from it. Otherwise modules are
+  loaded from `.lua` files next to the given path. Returns false if a
+  cartridge can't be opened.
+*/
+bool luacart_init(const char* path);
+
+/**
+  Loads the module with the given name as a function on top of the stack, just
+  like `luaL_loadfile()`. Modules inside a cartridge are handed to Lua straight
+  from the mapped file without being copied.
+*/
+int luacart_load(lua_State* L, const char* name);
+
+/**
+  Packs the game at the given path into a cartridge written to `output`, along
+  with the scripts it imports and every other file in its directory except
+  saves and caches. Scripts are stored as bytecode, and the game itself is
+  stored as `LUACART_ENTRY`. Imports are found by looking for `import()` calls
+  with literal names. If the game computes the names of any modules it
+  imports, every script is packed instead, skipping scripts that don't
+  compile. Returns 0 on success.
+*/
+int luacart_pack(const char* path, const char* output);
+
+/**
+  Activates the `import()` function within the given lua state.
+*/
+void luaopen_cart(lua_State* L);
+
+/**
+  Closes the cartridge, if one is open.
+*/
+void luacart_free(void);
+
+#endif
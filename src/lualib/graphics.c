@@ -18,42 +18,68 @@ static int luagraphics_color(lua_State* L) {
   return 0;
 }
 
+/**
+  Reads a point from the arguments, which is either two numbers or a single
+  value with `x` and `y` fields, like a `vec2`.
+*/
+static void check_point(lua_State* L, float* x, float* y) {
+  if (lua_isnumber(L, 1) || lua_isnoneornil(L, 1)) {
+    *x = (float)luaL_checknumber(L, 1);
+    *y = (float)luaL_checknumber(L, 2);
+    return;
+  }
+
+  lua_getfield(L, 1, "x");
+  lua_getfield(L, 1, "y");
+  if (!lua_isnumber(L, -2) || !lua_isnumber(L, -1))
+    luaL_argerror(L, 1, "number or vec2 expected");
+
+  *x = (float)lua_tonumber(L, -2);
+  *y = (float)lua_tonumber(L, -1);
+  lua_pop(L, 2);
+}
+
 static int luagraphics_plot(lua_State* L) {
-  graphics_plot((float)luaL_checknumber(L, 1), (float)luaL_checknumber(L, 2));
+  float x, y;
+  check_point(L, &x, &y);
+  graphics_plot(x, y);
   return 0;
 }
 
 static int luagraphics_move(lua_State* L) {
-  graphics_move((float)luaL_checknumber(L, 1), (float)luaL_checknumber(L, 2));
+  float x, y;
+  check_point(L, &x, &y);
+  graphics_move(x, y);
   return 0;
 }
 
 static int luagraphics_draw(lua_State* L) {
-  graphics_draw();
+  if (!graphics_draw())
+    return luasystem_unwind(L);
   return 0;
 }
 
 /**
-  Returns the result from `GetRenderWidth()`.
+  Returns the result from `system_width()`.
 */
 static int luagraphics_width(lua_State* L) {
-  lua_pushinteger(L, GetRenderWidth());
+  lua_pushinteger(L, system_width());
   return 1;
 }
 
 /**
-  Returns the result from `GetRenderHeight()`.
+  Returns the result from `system_height()`.
 */
 static int luagraphics_height(lua_State* L) {
-  lua_pushinteger(L, GetRenderHeight());
+  lua_pushinteger(L, system_height());
   return 1;
 }
 
 /**
-  Returns `GetRenderHeight() / GetRenderWidth()`.
+  Returns `system_height() / system_width()`.
 */
 static int luagraphics_aspect(lua_State* L) {
-  lua_pushnumber(L, (float)GetRenderHeight() / (float)GetRenderWidth());
+  lua_pushnumber(L, (float)system_height() / (float)system_width());
   return 1;
 }
 
@@ -10,6 +10,7 @@
 #define LUALIB_GRAPHICS_H
 
 #include "../api/graphics.h"
+#include "system.h"
 #include <lauxlib.h>
 #include <lua.h>
 
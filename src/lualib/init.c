@@ -8,16 +8,25 @@
 
 #include "init.h"
 
-static lua_State* L;
+static INSTANCE_LOCAL lua_State* L;
+
+static INSTANCE_LOCAL double vlua_gc_budget = 0.0;
+static INSTANCE_LOCAL size_t vlua_gc_baseline = 0;
 
 void vlua_openlibs(lua_State* L) {
+  luaopen_native(L);
   luaopen_vbase(L);
   luaopen_vmath(L);
   luaopen_vstring(L);
+  luaopen_vtable(L);
+  luaopen_vvector(L);
   luaopen_graphics(L);
   luaopen_audio(L);
   luaopen_input(L);
   luaopen_system(L);
+  luaopen_storage(L);
+  luaopen_rewind(L);
+  luaopen_cart(L);
   // luaopen_string(L);
 
   // Remove string.dump.
@@ -27,34 +36,197 @@ void vlua_openlibs(lua_State* L) {
   // lua_pop(L, 1);
 }
 
-int vlua_init(const char* path) {
-  if (!(L = luaL_newstate()))
-    return 1;
-  vlua_openlibs(L);
+/**
+  Logs errors thrown outside of any protected call before Lua aborts.
+*/
+static int vlua_panic(lua_State* L) {
+  const char* error = lua_tostring(L, -1);
+  SYSTEM_PANIC_LOG(
+    "Unprotected error in call to Lua API (%s)", error ? error : "?"
+  );
+  return 0;
+}
 
-  if (luaL_dofile(L, path)) {
+/**
+  Returns the size of the Lua heap in bytes.
+*/
+static size_t vlua_heap(void) {
+  return (size_t)lua_gc(L, LUA_GCCOUNT, 0) * 1024 + lua_gc(L, LUA_GCCOUNTB, 0);
+}
+
+/**
+  Lets Lua collect garbage on its own only once the heap grows
+  `VLUA_GC_BACKSTOP_PAUSE` percent past its current size. On LuaJIT, restarting
+  with -1 sets the threshold from the pause instead of collecting right away.
+*/
+static void vlua_backstop(void) {
+  lua_gc(L, LUA_GCRESTART, -1);
+}
+
+/**
+  Runs incremental garbage collection steps until the given deadline or until
+  the budget runs out, whichever comes first. At least one step always runs so
+  collection keeps up when there's no time to spare, and if the heap has grown
+  too far since the last full collection, steps keep running until the cycle
+  finishes.
+*/
+static void vlua_collect(double deadline) {
+  double trace_start = trace_begin();
+  double start = system_clock();
+  double end = start + vlua_gc_budget;
+  if (deadline < end)
+    end = deadline;
+
+  do {
+    if (lua_gc(L, LUA_GCSTEP, VLUA_GC_STEP_KB)) {
+      vlua_gc_baseline = vlua_heap();
+      break;
+    }
+  } while (system_clock() < end ||
+           vlua_heap() > vlua_gc_baseline * VLUA_GC_LIMIT);
+
+  // Stepping moves the collection threshold, which would let allocations
+  // trigger collection again right away. Moving it back up leaves Lua's own
+  // collector as a backstop.
+  vlua_backstop();
+
+  system_record_gc(system_clock() - start, vlua_heap());
+  trace_end("gc", trace_start);
+}
+
+/**
+  Calls the function on top of the stack with the given number of arguments.
+  Returns false if the game stopped, either because it threw an error (which
+  is logged) or because the runtime is stopping.
+*/
+static bool vlua_call(int nargs) {
+  trace_lua_enter();
+  int status = lua_pcall(L, nargs, 0, 0);
+  trace_lua_leave();
+  if (status == 0)
+    return true;
+
+  if (!luasystem_unwinding(L, -1)) {
     const char* error = lua_tostring(L, -1);
-    char message[512];
-    strncpy(message, error, 512);
+    SYSTEM_PANIC_LOG("%s", error ? error : "(error object is not a string)");
+    system_quit(1);
+  }
+
+  lua_pop(L, 1);
+  return false;
+}
+
+/**
+  Returns true if the game defined an `update()` or `draw()` callback.
+*/
+static bool vlua_has_callbacks(void) {
+  lua_getglobal(L, "update");
+  lua_getglobal(L, "draw");
+  bool result = lua_isfunction(L, -2) || lua_isfunction(L, -1);
+  lua_pop(L, 2);
+  return result;
+}
+
+/**
+  Calls the game's `update(dt)` callback once per tick and its `draw()`
+  callback once per presented frame, then draws and interrupts, until the
+  runtime stops. Drawing is skipped entirely on frames the frame pacer skips.
+  The table the game gave `rewind.track()` is snapshotted after every update.
+*/
+static void vlua_run_callbacks(void) {
+  const lua_Number dt = 1.0 / SYSTEM_TICK_RATE;
 
-    SYSTEM_PANIC_LOG("%s", message);
+  do {
+    // While the rewind key is held, ticks step back through the snapshots of
+    // the game instead of running it.
+    if (!rewind_held() || !luarewind_step(L)) {
+      lua_getglobal(L, "update");
+      if (lua_isfunction(L, -1)) {
+        lua_pushnumber(L, dt);
+        if (!vlua_call(1))
+          return;
+      } else {
+        lua_pop(L, 1);
+      }
+      luarewind_capture(L);
+    }
 
-    if (L) {
-      lua_close(L);
-      L = NULL;
+    if (!system_frame_skipped()) {
+      lua_getglobal(L, "draw");
+      if (!lua_isfunction(L, -1))
+        lua_pop(L, 1);
+      else if (!vlua_call(0))
+        return;
     }
+  } while (graphics_draw());
+}
+
+int vlua_init(const char* path, vlua_args_t args) {
+  if (!luacart_init(path))
     return 1;
+  storage_init(path);
+
+  double trace_start = trace_begin();
+  pool_init(args.memory_cap);
+  if ((L = lua_newstate(pool_alloc, NULL))) {
+    lua_atpanic(L, vlua_panic);
+  } else {
+    // LuaJIT only accepts custom allocators on 64-bit builds with GC64.
+    SYSTEM_WARN_LOG(
+      "This Lua build doesn't support custom allocators, so memory can't be "
+      "capped or tracked."
+    );
+    if (!(L = luaL_newstate()))
+      return 1;
   }
+  vlua_openlibs(L);
+  trace_end("vlua_init", trace_start);
 
-  lua_close(L);
-  L = NULL;
-  return 0;
+  if (args.profile_path)
+    profiler_start(L, args.profile_path);
+  if (args.jit_report)
+    jitreport_start(L);
+
+  // Collection is driven by the frame pacer instead of by allocations, so it
+  // happens while waiting for the next present rather than mid-update. Lua
+  // still collects if the heap grows too far between presents, since running
+  // out of memory is worse than a slow frame.
+  if (args.gc_budget > 0.0) {
+    lua_gc(L, LUA_GCSETPAUSE, VLUA_GC_BACKSTOP_PAUSE);
+    vlua_backstop();
+    vlua_gc_budget = args.gc_budget;
+    vlua_gc_baseline = vlua_heap();
+    system_on_idle(vlua_collect);
+  }
+
+  trace_start = trace_begin();
+  int status = cart_loaded() ? luacart_load(L, LUACART_ENTRY)
+                             : bytecode_load(L, path);
+  trace_end("load", trace_start);
+
+  if (status) {
+    const char* error = lua_tostring(L, -1);
+    SYSTEM_PANIC_LOG("%s", error ? error : "Failed to load the game!");
+    system_quit(1);
+  } else if (vlua_call(0) && vlua_has_callbacks()) {
+    vlua_run_callbacks();
+  }
+
+  vlua_free();
+  return system_exit_status();
 }
 
 void vlua_free(void) {
+  system_on_idle(NULL);
   if (L) {
+    profiler_stop(L);
+    jitreport_stop(L);
     lua_close(L);
     L = NULL;
   }
+  luarewind_free();
+  pool_free();
+  luacart_free();
+  storage_close();
 }
 
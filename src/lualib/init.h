@@ -9,26 +9,67 @@
 #ifndef LUALIB_INIT_H
 #define LUALIB_INIT_H
 
+#include "native.h"
 #include "vbase.h"
 #include "vmath.h"
 #include "vstring.h"
+#include "vtable.h"
+#include "vvector.h"
 #include "system.h"
 #include "input.h"
 #include "graphics.h"
 #include "audio.h"
+#include "storage.h"
+#include "rewind.h"
+#include "profiler.h"
+#include "jitreport.h"
+#include "bytecode.h"
+#include "cart.h"
+#include "pool.h"
 #include <lua.h>
 #include <lauxlib.h>
 #include <string.h>
 
+// How long garbage collection can run each frame by default, in seconds.
+#define VLUA_GC_BUDGET 0.001
+
+// How many kilobytes of garbage collection work each step does.
+#define VLUA_GC_STEP_KB 16
+
+// How much the heap can grow past its size after the last full collection
+// before garbage collection keeps going past its budget to catch up.
+#define VLUA_GC_LIMIT 2
+
+// How far the heap can grow, in percent of its size after the last collection,
+// before Lua's own collector steps in. It's a backstop for code that allocates
+// a lot without waiting for the next present, like a long main chunk.
+#define VLUA_GC_BACKSTOP_PAUSE 300
+
+/**
+  Options for running a game.
+*/
+typedef struct {
+  // If not NULL, the game is profiled and the samples are written here.
+  const char* profile_path;
+  // If not 0, the most bytes the game can allocate.
+  size_t memory_cap;
+  // How long garbage collection can run each frame in seconds. If 0, Lua
+  // collects garbage on its own whenever it allocates.
+  double gc_budget;
+  // If true, logs how many traces LuaJIT compiled and where it gave up.
+  bool jit_report;
+} vlua_args_t;
+
 /**
   Initializes all libraries within the given lua state.
 */
 void vlua_openlibs(lua_State* L);
 
 /**
-  Starts the game at the given path.
+  Starts the game at the given path, which is either a `.lua` file or a
+  cartridge.
 */
-int vlua_init(const char* path);
+int vlua_init(const char* path, vlua_args_t args);
 
 /**
   Frees Lua, effectively stopping the runtime. This function can be used within
@@ -90,24 +90,49 @@ static int luainput_tapped(lua_State* L) {
   By default this function will try to get input from controller one, but
   optionally a controller index can be given to specify which controller to
   read input from.
+
+  A table can be passed as the second argument to have it filled in and
+  returned instead of creating a new table, so games can poll every frame
+  without allocating.
 */
 static int luainput_grab(lua_State* L) {
-  const int controller_id = luaL_optint(L, 1, 1);
+  const input_mask_t mask = input_mask(luaL_optint(L, 1, 1));
+
+  if (lua_isnoneornil(L, 2))
+    lua_createtable(L, 0, INPUT_BUTTONS);
+  else {
+    luaL_checktype(L, 2, LUA_TTABLE);
+    lua_settop(L, 2);
+  }
 
-  lua_createtable(L, 0, 12);
-  for (int i = 0; i < 12; i++) {
-    lua_pushboolean(L, input_pressed(i, controller_id));
+  for (int i = 0; i < INPUT_BUTTONS; i++) {
+    lua_pushboolean(L, mask >> i & 1);
     lua_setfield(L, -2, input_names[i]);
   }
   return 1;
 }
 
+/**
+  Returns the state of every button on the given controller packed into an
+  integer, where bit `n` is set when the button with input code `n + 1` is
+  held down.
+
+  By default this function will try to get input from controller one, but
+  optionally a controller index can be given to specify which controller to
+  read input from.
+*/
+static int luainput_mask(lua_State* L) {
+  lua_pushinteger(L, input_mask(luaL_optint(L, 1, 1)));
+  return 1;
+}
+
 void luaopen_input(lua_State* L) {
   // clang-format off
   static const luaL_Reg luainput_lib[] = {
     {"pressed", luainput_pressed},
     {"tapped", luainput_tapped},
     {"grab", luainput_grab},
+    {"mask", luainput_mask},
     {NULL, NULL}
   };
   //clang-format on
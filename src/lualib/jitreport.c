@@ -0,0 +1,105 @@
+/**
+  src/lualib/jitreport.c
+
+  Written by DoelJavid for V-GAME.
+
+  https://github.com/DoelJavid/v-game
+*/
+
+#include "jitreport.h"
+
+// Checked before touching the registry, since looking up the report's field
+// allocates its name if the report never started, which can fail once the
+// game has used up its memory.
+static INSTANCE_LOCAL bool jitreport_running = false;
+
+#if defined(LUA_JITLIBNAME)
+/**
+  Counts traces through `jit.attach()` and returns the function that detaches
+  the handler and logs the report. Receives the native libraries, a function
+  logging a line, and how many locations to list.
+
+  Abort reasons are LuaJIT's numeric trace error codes, since the table naming
+  them lives in `jit.vmdef`, which isn't part of the runtime.
+*/
+static const char jitreport_source[] =
+  "local native, log, top = ...\n"
+  "local jit, funcinfo = native.jit, native[\"jit.util\"].funcinfo\n"
+  "local format, sort = native.string.format, native.table.sort\n"
+  "local started, compiled, aborted, aborts = 0, 0, 0, {}\n"
+  "\n"
+  "local function handler(what, trace, func, pc, code)\n"
+  "  if what == \"start\" then\n"
+  "    started = started + 1\n"
+  "  elseif what == \"stop\" then\n"
+  "    compiled = compiled + 1\n"
+  "  elseif what == \"abort\" then\n"
+  "    aborted = aborted + 1\n"
+  "    local info = funcinfo(func, pc)\n"
+  "    local where = format(\"%s (error %s)\", info.loc or info.source or \"?\",\n"
+  "      native.tostring(code))\n"
+  "    aborts[where] = (aborts[where] or 0) + 1\n"
+  "  end\n"
+  "end\n"
+  "jit.attach(handler, \"trace\")\n"
+  "\n"
+  "return function()\n"
+  "  jit.attach(handler)\n"
+  "  log(format(\"JIT: %d traces started, %d compiled, %d aborted.\",\n"
+  "    started, compiled, aborted))\n"
+  "\n"
+  "  local locations = {}\n"
+  "  for where in native.next, aborts do\n"
+  "    locations[#locations + 1] = where\n"
+  "  end\n"
+  "  sort(locations, function(a, b)\n"
+  "    if aborts[a] ~= aborts[b] then\n"
+  "      return aborts[a] > aborts[b]\n"
+  "    end\n"
+  "    return a < b\n"
+  "  end)\n"
+  "  for i = 1, native.math.min(top, #locations) do\n"
+  "    log(format(\"  %6d  %s\", aborts[locations[i]], locations[i]))\n"
+  "  end\n"
+  "end\n";
+
+/**
+  Logs a line of the report.
+*/
+static int jitreport_log(lua_State* L) {
+  SYSTEM_LOG("%s", luaL_checkstring(L, 1));
+  return 0;
+}
+#endif
+
+void jitreport_start(lua_State* L) {
+#if defined(LUA_JITLIBNAME)
+  lua_pushcfunction(L, jitreport_log);
+  lua_pushinteger(L, JITREPORT_TOP);
+  luanative_run(L, "=[jitreport]", jitreport_source, 2, 1);
+  lua_setfield(L, LUA_REGISTRYINDEX, JITREPORT_REGISTRY);
+  jitreport_running = true;
+#else
+  (void)L;
+  SYSTEM_WARN_LOG("JIT reports need LuaJIT, ignoring --jit-report.");
+#endif
+}
+
+void jitreport_stop(lua_State* L) {
+  if (!jitreport_running)
+    return;
+
+  jitreport_running = false;
+  lua_getfield(L, LUA_REGISTRYINDEX, JITREPORT_REGISTRY);
+  if (!lua_isfunction(L, -1)) {
+    lua_pop(L, 1);
+    return;
+  }
+
+  lua_pushnil(L);
+  lua_setfield(L, LUA_REGISTRYINDEX, JITREPORT_REGISTRY);
+  if (lua_pcall(L, 0, 0, 0) != 0) {
+    SYSTEM_ERROR_LOG("Failed to write the JIT report: %s", lua_tostring(L, -1));
+    lua_pop(L, 1);
+  }
+}
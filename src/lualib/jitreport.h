@@ -0,0 +1,40 @@
+/**
+  src/lualib/jitreport.h
+
+  Written by DoelJavid for V-GAME.
+
+  https://github.com/DoelJavid/v-game
+*/
+
+#ifndef LUALIB_JITREPORT_H
+#define LUALIB_JITREPORT_H
+
+#include "../api/system.h"
+#include "native.h"
+#include <lauxlib.h>
+#include <lua.h>
+#include <lualib.h>
+
+// The registry field holding the function that prints the report.
+#define JITREPORT_REGISTRY "vgame.jitreport"
+
+// How many of the places aborting the most traces the report lists.
+#define JITREPORT_TOP 10
+
+/**
+  Starts counting the traces LuaJIT compiles and aborts within the given state.
+  When the report is stopped, the totals are logged along with the source
+  locations that aborted the most traces, which shows whether a game's hot
+  loops actually get compiled.
+
+  Only warns on Lua implementations without a JIT compiler.
+*/
+void jitreport_start(lua_State* L);
+
+/**
+  Stops counting traces and logs the report. Must be called before the Lua
+  state is closed. Does nothing if the report isn't running.
+*/
+void jitreport_stop(lua_State* L);
+
+#endif
@@ -0,0 +1,138 @@
+/**
+  src/lualib/native.c
+
+  Written by DoelJavid for V-GAME.
+
+  https://github.com/DoelJavid/v-game
+*/
+
+#include "native.h"
+
+// clang-format off
+static const luaL_Reg luanative_libs[] = {
+  {"_G", luaopen_base},
+  {LUA_STRLIBNAME, luaopen_string},
+  {LUA_MATHLIBNAME, luaopen_math},
+  {LUA_TABLIBNAME, luaopen_table},
+#if defined(LUA_JITLIBNAME)
+  {LUA_JITLIBNAME, luaopen_jit},
+  {LUA_FFILIBNAME, luaopen_ffi},
+#endif
+  {NULL, NULL}
+};
+// clang-format on
+
+/**
+  Loads the preloaded module on top of the stack, whose name is right below
+  it, into the native table at the given index. A module named `table.new` is
+  stored as the `new` field of the `table` library. Pops the module, leaving
+  its name for `lua_next()`.
+*/
+static void preload(lua_State* L, int natives) {
+  const char* name =
+    lua_type(L, -2) == LUA_TSTRING ? lua_tostring(L, -2) : NULL;
+  const char* dot = name ? strchr(name, '.') : NULL;
+  if (!dot || !lua_isfunction(L, -1)) {
+    lua_pop(L, 1);
+    return;
+  }
+
+  lua_pushlstring(L, name, dot - name);
+  lua_rawget(L, natives);
+  if (!lua_istable(L, -1)) {
+    lua_pop(L, 2);
+    return;
+  }
+
+  lua_insert(L, -2);
+  lua_pushvalue(L, -3);
+  lua_call(L, 1, 1);
+  lua_setfield(L, -2, dot + 1);
+  lua_pop(L, 1);
+}
+
+void luaopen_native(lua_State* L) {
+  // Some libraries, like `ffi`, only return their table without making it a
+  // global, so every library's table is kept by name.
+  lua_newtable(L);
+  int natives = lua_gettop(L);
+  for (const luaL_Reg* lib = luanative_libs; lib->func; lib++) {
+    lua_pushcfunction(L, lib->func);
+    lua_pushstring(L, lib->name);
+    lua_call(L, 1, 1);
+    lua_setfield(L, -2, lib->name);
+  }
+
+  // LuaJIT only preloads some functions, like `table.new`, for `require()`.
+  // Load them into the tables they belong to.
+  lua_getfield(L, LUA_REGISTRYINDEX, "_PRELOAD");
+  if (lua_istable(L, -1)) {
+    lua_pushnil(L);
+    while (lua_next(L, -2))
+      preload(L, natives);
+  }
+  lua_pop(L, 1);
+  lua_pushnil(L);
+  lua_setfield(L, LUA_REGISTRYINDEX, "_PRELOAD");
+
+  // Move every global the libraries defined into the native table. Globals
+  // can't be removed while traversing them, so that's done afterwards.
+  lua_pushnil(L);
+  while (lua_next(L, LUA_GLOBALSINDEX)) {
+    lua_pushvalue(L, -2);
+    lua_insert(L, -2);
+    lua_rawset(L, -4);
+  }
+
+  lua_pushnil(L);
+  while (lua_next(L, -2)) {
+    lua_pop(L, 1);
+    lua_pushvalue(L, -1);
+    lua_pushnil(L);
+    lua_rawset(L, LUA_GLOBALSINDEX);
+  }
+
+  // Keep modules that were only registered as loaded, like `jit.util`, then
+  // forget about all of them so V-GAME's libraries start from scratch.
+  lua_getfield(L, LUA_REGISTRYINDEX, "_LOADED");
+  lua_pushnil(L);
+  while (lua_next(L, -2)) {
+    lua_pushvalue(L, -2);
+    lua_rawget(L, -5);
+    if (lua_isnil(L, -1)) {
+      lua_pop(L, 1);
+      lua_pushvalue(L, -2);
+      lua_insert(L, -2);
+      lua_rawset(L, -5);
+    } else {
+      lua_pop(L, 2);
+    }
+  }
+  lua_pop(L, 1);
+  lua_newtable(L);
+  lua_setfield(L, LUA_REGISTRYINDEX, "_LOADED");
+
+  // The string library gives strings a metatable, which games never had.
+  lua_pushliteral(L, "");
+  lua_pushnil(L);
+  lua_setmetatable(L, -2);
+  lua_pop(L, 1);
+
+  lua_setfield(L, LUA_REGISTRYINDEX, LUANATIVE_REGISTRY);
+}
+
+void luanative_push(lua_State* L) {
+  lua_getfield(L, LUA_REGISTRYINDEX, LUANATIVE_REGISTRY);
+}
+
+void luanative_run(
+  lua_State* L, const char* name, const char* source, int nargs, int nresults
+) {
+  if (luaL_loadbuffer(L, source, strlen(source), name) != 0)
+    lua_error(L);
+
+  lua_insert(L, -(nargs + 1));
+  luanative_push(L);
+  lua_insert(L, -(nargs + 1));
+  lua_call(L, nargs + 1, nresults);
+}
@@ -0,0 +1,48 @@
+/**
+  src/lualib/native.h
+
+  Written by DoelJavid for V-GAME.
+
+  https://github.com/DoelJavid/v-game
+*/
+
+#ifndef LUALIB_NATIVE_H
+#define LUALIB_NATIVE_H
+
+#include <lauxlib.h>
+#include <lua.h>
+#include <lualib.h>
+#include <string.h>
+
+// The registry field holding Lua's own libraries.
+#define LUANATIVE_REGISTRY "vgame.native"
+
+/**
+  Opens Lua's own base, string, math and table libraries (plus LuaJIT's `jit`
+  and `ffi` libraries when available) without exposing any of them to games. Everything
+  they define is moved into a table in the registry instead, so V-GAME's
+  libraries can be built on top of the fast functions LuaJIT knows how to
+  compile.
+
+  Must be called before any other library is opened, since Lua's libraries
+  would overwrite V-GAME's globals.
+*/
+void luaopen_native(lua_State* L);
+
+/**
+  Pushes the table of native libraries. Base functions are fields of the table
+  itself, and libraries are nested tables like `string`.
+*/
+void luanative_push(lua_State* L);
+
+/**
+  Runs a chunk of Lua code embedded in the runtime. The chunk receives the
+  table of native libraries followed by the `nargs` values on top of the
+  stack, which are popped, and leaves `nresults` results. Errors are raised
+  just like `lua_call()`.
+*/
+void luanative_run(
+  lua_State* L, const char* name, const char* source, int nargs, int nresults
+);
+
+#endif
@@ -0,0 +1,195 @@
+/**
+  src/lualib/pool.c
+
+  Written by DoelJavid for V-GAME.
+
+  https://github.com/DoelJavid/v-game
+*/
+
+#include "pool.h"
+
+// Blocks in a slab start after this many bytes, which hold the link to the
+// next slab and keep blocks 16-byte aligned.
+#define POOL_SLAB_HEADER 16
+
+// The index of large allocations within the usage stats.
+#define POOL_LARGE POOL_CLASSES
+
+/**
+  A free block, linked to the next free block of the same size class.
+*/
+typedef struct pool_block_t {
+  struct pool_block_t* next;
+} pool_block_t;
+
+// clang-format off
+static const size_t pool_sizes[POOL_CLASSES] = {
+  16, 32, 48, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 384, 448, 512
+};
+// clang-format on
+
+// Maps a size rounded up to 16 bytes, divided by 16, to its size class.
+static INSTANCE_LOCAL uint8_t pool_lookup[POOL_MAX_SMALL / 16 + 1];
+
+static INSTANCE_LOCAL pool_block_t* pool_free_lists[POOL_CLASSES];
+static INSTANCE_LOCAL void* pool_slabs = NULL;
+static INSTANCE_LOCAL pool_stats_t pool_usage;
+static INSTANCE_LOCAL bool pool_used = false;
+
+/**
+  Returns the size class for an allocation of the given size, or `POOL_LARGE`
+  if it's too big for any class.
+*/
+static int class_of(size_t size) {
+  return size <= POOL_MAX_SMALL ? pool_lookup[(size + 15) >> 4] : POOL_LARGE;
+}
+
+/**
+  Carves a new slab into free blocks for the given size class. Returns false
+  if out of memory.
+*/
+static bool refill(int size_class) {
+  char* slab = malloc(POOL_SLAB_SIZE);
+  if (!slab)
+    return false;
+
+  *(void**)slab = pool_slabs;
+  pool_slabs = slab;
+  pool_usage.reserved += POOL_SLAB_SIZE;
+
+  size_t size = pool_sizes[size_class];
+  for (size_t offset = POOL_SLAB_HEADER; offset + size <= POOL_SLAB_SIZE;
+       offset += size) {
+    pool_block_t* block = (pool_block_t*)&slab[offset];
+    block->next = pool_free_lists[size_class];
+    pool_free_lists[size_class] = block;
+  }
+
+  return true;
+}
+
+/**
+  Allocates a block of the given size. If `capped`, fails when the block would
+  go over the memory cap.
+*/
+static void* alloc_block(size_t size, bool capped) {
+  int size_class = class_of(size);
+  size_t cost = size_class == POOL_LARGE ? size : pool_sizes[size_class];
+  if (capped && pool_usage.cap && pool_usage.used + cost > pool_usage.cap)
+    return NULL;
+
+  void* block;
+  if (size_class == POOL_LARGE) {
+    if (!(block = malloc(size)))
+      return NULL;
+  } else {
+    if (!pool_free_lists[size_class] && !refill(size_class))
+      return NULL;
+    block = pool_free_lists[size_class];
+    pool_free_lists[size_class] = pool_free_lists[size_class]->next;
+  }
+
+  pool_used = true;
+  pool_usage.used += cost;
+  if (pool_usage.used > pool_usage.peak)
+    pool_usage.peak = pool_usage.used;
+  pool_usage.classes[size_class].count++;
+  pool_usage.classes[size_class].bytes += cost;
+  return block;
+}
+
+/**
+  Frees a block that was allocated with the given size.
+*/
+static void free_block(void* ptr, size_t size) {
+  int size_class = class_of(size);
+  size_t cost = size_class == POOL_LARGE ? size : pool_sizes[size_class];
+
+  if (size_class == POOL_LARGE) {
+    free(ptr);
+  } else {
+    pool_block_t* block = ptr;
+    block->next = pool_free_lists[size_class];
+    pool_free_lists[size_class] = block;
+  }
+
+  pool_usage.used -= cost;
+  pool_usage.classes[size_class].count--;
+  pool_usage.classes[size_class].bytes -= cost;
+}
+
+void pool_init(size_t cap) {
+  pool_free();
+  pool_usage.cap = cap;
+
+  int size_class = 0;
+  for (size_t i = 0; i <= POOL_MAX_SMALL / 16; i++) {
+    while (pool_sizes[size_class] < i * 16)
+      size_class++;
+    pool_lookup[i] = size_class;
+  }
+
+  for (int i = 0; i < POOL_CLASSES; i++)
+    pool_usage.classes[i].size = pool_sizes[i];
+}
+
+void* pool_alloc(void* ud, void* ptr, size_t osize, size_t nsize) {
+  (void)ud;
+  if (nsize == 0) {
+    if (ptr)
+      free_block(ptr, osize);
+    return NULL;
+  }
+
+  if (!ptr)
+    return alloc_block(nsize, true);
+
+  int old_class = class_of(osize), new_class = class_of(nsize);
+  if (old_class == new_class && old_class != POOL_LARGE)
+    return ptr;
+
+  if (old_class == POOL_LARGE && new_class == POOL_LARGE) {
+    if (nsize > osize && pool_usage.cap &&
+        pool_usage.used + (nsize - osize) > pool_usage.cap)
+      return NULL;
+
+    void* block = realloc(ptr, nsize);
+    if (!block)
+      return NULL;
+
+    pool_usage.used += nsize - osize;
+    pool_usage.classes[POOL_LARGE].bytes += nsize - osize;
+    if (pool_usage.used > pool_usage.peak)
+      pool_usage.peak = pool_usage.used;
+    return block;
+  }
+
+  // Lua expects shrinking to always succeed, so only growth is capped.
+  void* block = alloc_block(nsize, nsize > osize);
+  if (!block)
+    return NULL;
+
+  memcpy(block, ptr, osize < nsize ? osize : nsize);
+  free_block(ptr, osize);
+  return block;
+}
+
+bool pool_active(void) {
+  return pool_used;
+}
+
+pool_stats_t pool_stats(void) {
+  return pool_usage;
+}
+
+void pool_free(void) {
+  while (pool_slabs) {
+    void* next = *(void**)pool_slabs;
+    free(pool_slabs);
+    pool_slabs = next;
+  }
+
+  memset(pool_free_lists, 0, sizeof(pool_free_lists));
+  memset(&pool_usage, 0, sizeof(pool_usage));
+  pool_used = false;
+}
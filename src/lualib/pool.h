@@ -0,0 +1,86 @@
+/**
+  src/lualib/pool.h
+
+  Written by DoelJavid for V-GAME.
+
+  https://github.com/DoelJavid/v-game
+*/
+
+#ifndef LUALIB_POOL_H
+#define LUALIB_POOL_H
+
+#include "../api/system.h"
+#include <lua.h>
+#include <stdint.h>
+#include <string.h>
+
+// How many size classes small allocations are sorted into.
+#define POOL_CLASSES 16
+
+// The largest allocation served from a size class. Anything bigger goes
+// straight to `malloc()`.
+#define POOL_MAX_SMALL 512
+
+// How many bytes each slab carved into blocks holds.
+#define POOL_SLAB_SIZE 65536
+
+/**
+  Usage of a single size class.
+*/
+typedef struct {
+  // The size of every block in the class, or 0 for large allocations.
+  size_t size;
+  // How many blocks are in use.
+  size_t count;
+  // How many bytes those blocks hold.
+  size_t bytes;
+} pool_class_stats_t;
+
+/**
+  A snapshot of the allocator's usage. Every size is in bytes.
+*/
+typedef struct {
+  // Bytes in use by Lua, counting small blocks at their full class size.
+  size_t used;
+  // The most bytes ever in use at once.
+  size_t peak;
+  // The memory cap, or 0 if there is none.
+  size_t cap;
+  // Bytes reserved from the system for slabs.
+  size_t reserved;
+  // Every size class, followed by large allocations.
+  pool_class_stats_t classes[POOL_CLASSES + 1];
+} pool_stats_t;
+
+/**
+  Prepares the allocator. If `cap` isn't 0, allocations that would put more
+  than `cap` bytes in use fail, which Lua reports as an out of memory error.
+*/
+void pool_init(size_t cap);
+
+/**
+  A `lua_Alloc` serving small blocks from per-size-class slabs, so the many
+  tiny tables, closures and strings a game creates never touch `malloc()`.
+  Freed blocks go back to their class's free list and are never returned to
+  the system until `pool_free()`.
+*/
+void* pool_alloc(void* ud, void* ptr, size_t osize, size_t nsize);
+
+/**
+  Returns true if the allocator has been used since `pool_init()`. It isn't
+  when the Lua build can't use custom allocators.
+*/
+bool pool_active(void);
+
+/**
+  Returns a snapshot of the allocator's usage.
+*/
+pool_stats_t pool_stats(void);
+
+/**
+  Releases every slab. Must only be called once the Lua state using the
+  allocator is closed.
+*/
+void pool_free(void);
+
+#endif
@@ -0,0 +1,366 @@
+/**
+  src/lualib/profiler.c
+
+  Written by DoelJavid for V-GAME.
+
+  https://github.com/DoelJavid/v-game
+*/
+
+#include "profiler.h"
+
+#if defined(LUA_JITLIBNAME)
+// From luajit.h, which isn't shipped within the include directory.
+typedef void (*luaJIT_profile_callback)(
+  void* data, lua_State* L, int samples, int vmstate
+);
+LUA_API void luaJIT_profile_start(
+  lua_State* L, const char* mode, luaJIT_profile_callback cb, void* data
+);
+LUA_API void luaJIT_profile_stop(lua_State* L);
+LUA_API const char* luaJIT_profile_dumpstack(
+  lua_State* L, const char* fmt, int depth, size_t* len
+);
+#endif
+
+/**
+  A unique stack and how many samples landed in it.
+*/
+typedef struct {
+  char* stack;
+  uint64_t hash;
+  size_t samples;
+} profiler_entry_t;
+
+/**
+  The Lua name of a C function registered by one of V-GAME's libraries.
+*/
+typedef struct {
+  lua_CFunction func;
+  char name[64];
+} profiler_symbol_t;
+
+static INSTANCE_LOCAL bool profiler_running = false;
+static INSTANCE_LOCAL char* profiler_path = NULL;
+
+static INSTANCE_LOCAL profiler_entry_t* profiler_entries = NULL;
+static INSTANCE_LOCAL size_t profiler_capacity = 0;
+static INSTANCE_LOCAL size_t profiler_count = 0;
+
+static INSTANCE_LOCAL profiler_symbol_t* profiler_symbols = NULL;
+static INSTANCE_LOCAL size_t profiler_symbol_count = 0;
+
+#if !defined(LUA_JITLIBNAME)
+static INSTANCE_LOCAL double profiler_next_sample = 0.0;
+#endif
+
+/**
+  FNV-1a hash of the given string.
+*/
+static uint64_t hash_string(const char* str, size_t length) {
+  uint64_t hash = 14695981039346656037ULL;
+  for (size_t i = 0; i < length; i++) {
+    hash ^= (unsigned char)str[i];
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+/**
+  Doubles the size of the stack table. Returns false if out of memory.
+*/
+static bool grow_entries(void) {
+  size_t capacity = profiler_capacity ? profiler_capacity * 2 : 1024;
+  profiler_entry_t* entries = calloc(capacity, sizeof(profiler_entry_t));
+  if (!entries)
+    return false;
+
+  for (size_t i = 0; i < profiler_capacity; i++) {
+    if (!profiler_entries[i].stack)
+      continue;
+
+    size_t slot = profiler_entries[i].hash & (capacity - 1);
+    while (entries[slot].stack)
+      slot = (slot + 1) & (capacity - 1);
+    entries[slot] = profiler_entries[i];
+  }
+
+  free(profiler_entries);
+  profiler_entries = entries;
+  profiler_capacity = capacity;
+  return true;
+}
+
+/**
+  Adds samples to the given folded stack.
+*/
+static void record_stack(const char* stack, size_t length, size_t samples) {
+  if (profiler_count * 10 >= profiler_capacity * 7 && !grow_entries())
+    return;
+
+  uint64_t hash = hash_string(stack, length);
+  size_t slot = hash & (profiler_capacity - 1);
+
+  while (profiler_entries[slot].stack) {
+    profiler_entry_t* entry = &profiler_entries[slot];
+    if (entry->hash == hash && strncmp(entry->stack, stack, length) == 0 &&
+        entry->stack[length] == '\0') {
+      entry->samples += samples;
+      return;
+    }
+    slot = (slot + 1) & (profiler_capacity - 1);
+  }
+
+  char* copy = malloc(length + 1);
+  if (!copy)
+    return;
+
+  memcpy(copy, stack, length);
+  copy[length] = '\0';
+  profiler_entries[slot] = (profiler_entry_t){copy, hash, samples};
+  profiler_count++;
+}
+
+/**
+  Returns the Lua name of a registered C function, or NULL if it isn't one of
+  V-GAME's.
+*/
+static const char* find_symbol(lua_CFunction func) {
+  for (size_t i = 0; i < profiler_symbol_count; i++)
+    if (profiler_symbols[i].func == func)
+      return profiler_symbols[i].name;
+  return NULL;
+}
+
+/**
+  Remembers the Lua name of the C function at the top of the stack.
+*/
+static void add_symbol(lua_State* L, const char* prefix, const char* name) {
+  if (!lua_iscfunction(L, -1))
+    return;
+
+  profiler_symbol_t* symbols = realloc(
+    profiler_symbols, (profiler_symbol_count + 1) * sizeof(profiler_symbol_t)
+  );
+  if (!symbols)
+    return;
+
+  profiler_symbols = symbols;
+  profiler_symbol_t* symbol = &profiler_symbols[profiler_symbol_count++];
+  symbol->func = lua_tocfunction(L, -1);
+  snprintf(
+    symbol->name, sizeof(symbol->name), "%s%s%s", prefix ? prefix : "",
+    prefix ? "." : "", name
+  );
+}
+
+/**
+  Walks the globals and every library table within them to name all C
+  functions the game can call.
+*/
+static void collect_symbols(lua_State* L) {
+  lua_pushnil(L);
+  while (lua_next(L, LUA_GLOBALSINDEX)) {
+    if (lua_type(L, -2) == LUA_TSTRING) {
+      const char* name = lua_tostring(L, -2);
+
+      if (lua_istable(L, -1)) {
+        lua_pushnil(L);
+        while (lua_next(L, -2)) {
+          if (lua_type(L, -2) == LUA_TSTRING)
+            add_symbol(L, name, lua_tostring(L, -2));
+          lua_pop(L, 1);
+        }
+      } else
+        add_symbol(L, NULL, name);
+    }
+    lua_pop(L, 1);
+  }
+}
+
+/**
+  Appends a frame to a folded stack, replacing the characters folded stacks
+  use as delimiters.
+*/
+static size_t
+append_frame(char* stack, size_t length, const char* frame, size_t size) {
+  if (length > 0 && length < PROFILER_MAX_STACK - 1)
+    stack[length++] = ';';
+
+  for (size_t i = 0; i < size && length < PROFILER_MAX_STACK - 1; i++)
+    stack[length++] = frame[i] == ';' || frame[i] == ' ' ? '_' : frame[i];
+  return length;
+}
+
+#if defined(LUA_JITLIBNAME)
+
+/**
+  Called by LuaJIT's profiler. Dumps the current stack, names V-GAME's C
+  functions (which LuaJIT only knows by address), and records the result.
+*/
+static void
+profile_callback(void* data, lua_State* L, int samples, int vmstate) {
+  (void)data;
+
+  size_t dump_length;
+  const char* dump = luaJIT_profile_dumpstack(
+    L, "F;", -PROFILER_MAX_DEPTH, &dump_length
+  );
+
+  char stack[PROFILER_MAX_STACK];
+  size_t length = 0;
+
+  // Frames are separated by ';' and ordered from the outermost call inwards.
+  const char* end = dump + dump_length;
+  while (dump < end) {
+    const char* separator = memchr(dump, ';', end - dump);
+    size_t size = separator ? (size_t)(separator - dump) : (size_t)(end - dump);
+
+    const char* symbol = NULL;
+    void* address;
+    if (size > 1 && dump[0] == '@' && sscanf(dump + 1, "%p", &address) == 1)
+      symbol = find_symbol((lua_CFunction)address);
+
+    if (size > 0)
+      length = symbol ? append_frame(stack, length, symbol, strlen(symbol))
+                      : append_frame(stack, length, dump, size);
+
+    dump += size + 1;
+  }
+
+  // Show time spent outside of the game's code as its own leaf.
+  switch (vmstate) {
+  case 'G':
+    length = append_frame(stack, length, "[gc]", 4);
+    break;
+  case 'J':
+    length = append_frame(stack, length, "[jit]", 5);
+    break;
+  }
+
+  if (length == 0)
+    length = append_frame(stack, length, "[runtime]", 9);
+
+  stack[length] = '\0';
+  record_stack(stack, length, samples);
+}
+
+#else
+
+/**
+  Called by the count hook. Only samples once the sampling interval has passed
+  so the profile is weighted by time rather than by instructions.
+*/
+static void profile_hook(lua_State* L, lua_Debug* ar) {
+  double now = system_clock();
+  if (now < profiler_next_sample)
+    return;
+  profiler_next_sample = now + PROFILER_INTERVAL_MS / 1000.0;
+
+  lua_Debug frames[PROFILER_MAX_DEPTH];
+  int depth = 0;
+  while (depth < PROFILER_MAX_DEPTH && lua_getstack(L, depth, &frames[depth]))
+    depth++;
+
+  char stack[PROFILER_MAX_STACK];
+  size_t length = 0;
+
+  for (int i = depth - 1; i >= 0; i--) {
+    lua_Debug* frame = &frames[i];
+    lua_getinfo(L, "Snf", frame);
+
+    const char* symbol = NULL;
+    if (lua_iscfunction(L, -1))
+      symbol = find_symbol(lua_tocfunction(L, -1));
+    lua_pop(L, 1);
+
+    char name[256];
+    if (symbol)
+      snprintf(name, sizeof(name), "%s", symbol);
+    else if (frame->name)
+      snprintf(
+        name, sizeof(name), "%s:%s", frame->short_src, frame->name
+      );
+    else
+      snprintf(
+        name, sizeof(name), "%s:%d", frame->short_src, frame->linedefined
+      );
+
+    length = append_frame(stack, length, name, strlen(name));
+  }
+
+  stack[length] = '\0';
+  record_stack(stack, length, 1);
+}
+
+#endif
+
+void profiler_start(lua_State* L, const char* path) {
+  if (profiler_running)
+    return;
+
+  profiler_path = malloc(strlen(path) + 1);
+  if (!profiler_path || !grow_entries()) {
+    SYSTEM_ERROR_LOG("Failed to start the profiler!");
+    free(profiler_path);
+    profiler_path = NULL;
+    return;
+  }
+  strcpy(profiler_path, path);
+
+  collect_symbols(L);
+  profiler_running = true;
+
+#if defined(LUA_JITLIBNAME)
+  char mode[16];
+  snprintf(mode, sizeof(mode), "i%d", PROFILER_INTERVAL_MS);
+  luaJIT_profile_start(L, mode, profile_callback, NULL);
+#else
+  profiler_next_sample = system_clock();
+  lua_sethook(L, profile_hook, LUA_MASKCOUNT, 200);
+#endif
+
+  SYSTEM_LOG("Profiling to %s", path);
+}
+
+void profiler_stop(lua_State* L) {
+  if (!profiler_running)
+    return;
+  profiler_running = false;
+
+#if defined(LUA_JITLIBNAME)
+  luaJIT_profile_stop(L);
+#else
+  lua_sethook(L, NULL, 0, 0);
+#endif
+
+  FILE* file = fopen(profiler_path, "w");
+  if (file) {
+    size_t total = 0;
+    for (size_t i = 0; i < profiler_capacity; i++) {
+      if (!profiler_entries[i].stack)
+        continue;
+
+      fprintf(
+        file, "%s %zu\n", profiler_entries[i].stack,
+        profiler_entries[i].samples
+      );
+      total += profiler_entries[i].samples;
+    }
+
+    fclose(file);
+    SYSTEM_LOG("Wrote %zu profiler samples to %s", total, profiler_path);
+  } else
+    SYSTEM_ERROR_LOG("Failed to write profile to \"%s\"!", profiler_path);
+
+  for (size_t i = 0; i < profiler_capacity; i++)
+    free(profiler_entries[i].stack);
+  free(profiler_entries);
+  free(profiler_symbols);
+  free(profiler_path);
+
+  profiler_entries = NULL;
+  profiler_capacity = profiler_count = 0;
+  profiler_symbols = NULL;
+  profiler_symbol_count = 0;
+  profiler_path = NULL;
+}
@@ -0,0 +1,47 @@
+/**
+  src/lualib/profiler.h
+
+  Written by DoelJavid for V-GAME.
+
+  https://github.com/DoelJavid/v-game
+*/
+
+#ifndef LUALIB_PROFILER_H
+#define LUALIB_PROFILER_H
+
+#include "../api/system.h"
+#include <lauxlib.h>
+#include <lua.h>
+#include <lualib.h>
+#include <stdint.h>
+#include <string.h>
+
+// How often the profiler samples the Lua stack, in milliseconds.
+#define PROFILER_INTERVAL_MS 1
+
+// The deepest stack the profiler records, and the longest folded stack string.
+#define PROFILER_MAX_DEPTH 64
+#define PROFILER_MAX_STACK 2048
+
+/**
+  Starts sampling the Lua stack of the given state. When the profiler is
+  stopped, the samples are written to the given path as collapsed stacks (one
+  `frame;frame;frame count` line per unique stack), which standard flamegraph
+  tools can read directly.
+
+  On LuaJIT, this uses LuaJIT's built-in sampling profiler. On other Lua
+  implementations it falls back to a count hook that checks the clock every
+  few hundred instructions.
+
+  C functions registered by V-GAME's libraries show up by their Lua name, like
+  `graphics.plot`.
+*/
+void profiler_start(lua_State* L, const char* path);
+
+/**
+  Stops the profiler and writes the samples to disk. Must be called before the
+  Lua state is closed. Does nothing if the profiler isn't running.
+*/
+void profiler_stop(lua_State* L);
+
+#endif
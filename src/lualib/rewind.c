@@ -0,0 +1,210 @@
+/**
+  src/lualib/rewind.c
+
+  Written by DoelJavid for V-GAME.
+
+  https://github.com/DoelJavid/v-game
+*/
+
+#include "rewind.h"
+
+static INSTANCE_LOCAL bool luarewind_tracking = false;
+
+// Set while stepping back, so sounds are only cut when rewinding starts.
+static INSTANCE_LOCAL bool luarewind_rewinding = false;
+
+/**
+  Stops tracking and forgets every snapshot.
+*/
+static void untrack(lua_State* L) {
+  lua_pushnil(L);
+  lua_setfield(L, LUA_REGISTRYINDEX, LUAREWIND_REGISTRY);
+  luarewind_tracking = false;
+  rewind_free();
+}
+
+/**
+  Snapshots the tracked table. Throws if the table can't be saved.
+*/
+static int snapshot(lua_State* L) {
+  lua_getfield(L, LUA_REGISTRYINDEX, LUAREWIND_REGISTRY);
+
+  size_t length;
+  char* data = luastorage_encode(L, -1, &length);
+  rewind_push(data, length);
+  free(data);
+  return 0;
+}
+
+void luarewind_capture(lua_State* L) {
+  luarewind_rewinding = false;
+  if (!luarewind_tracking)
+    return;
+
+  // lua_cpcall() also protects creating the function, which can run out of
+  // memory too.
+  double trace_start = trace_begin();
+  if (lua_cpcall(L, snapshot, NULL) != 0) {
+    const char* error = lua_tostring(L, -1);
+    SYSTEM_WARN_LOG(
+      "Stopped rewinding, the game can't be snapshotted: %s",
+      error ? error : "?"
+    );
+    lua_pop(L, 1);
+    untrack(L);
+  }
+  trace_end("rewind", trace_start);
+}
+
+/**
+  Restores the tracked table to how it was a tick earlier. Returns false if
+  there's nothing to rewind to, and throws if memory runs out.
+*/
+static bool restore(lua_State* L) {
+  if (!luarewind_tracking)
+    return false;
+
+  size_t length;
+  const void* data = rewind_pop(&length);
+  if (!data || !luastorage_decode(L, data, length))
+    return false;
+
+  // Sounds from the future would keep playing over the past.
+  if (!luarewind_rewinding) {
+    for (int i = 0; i < AUDIO_CHANNELS; i++)
+      audio_stop(i);
+    luarewind_rewinding = true;
+  }
+
+  // The tracked table is refilled in place so the game's references to it
+  // stay valid.
+  lua_getfield(L, LUA_REGISTRYINDEX, LUAREWIND_REGISTRY);
+  lua_pushnil(L);
+  while (lua_next(L, -2)) {
+    lua_pop(L, 1);
+    lua_pushvalue(L, -1);
+    lua_pushnil(L);
+    lua_rawset(L, -4);
+  }
+
+  lua_pushnil(L);
+  while (lua_next(L, -3)) {
+    lua_pushvalue(L, -2);
+    lua_insert(L, -2);
+    lua_rawset(L, -4);
+  }
+
+  lua_pop(L, 2);
+  return true;
+}
+
+/**
+  Runs `restore()` and stores whether it stepped back in the given bool.
+*/
+static int step_back(lua_State* L) {
+  bool* stepped = lua_touserdata(L, 1);
+  *stepped = restore(L);
+  return 0;
+}
+
+bool luarewind_step(lua_State* L) {
+  if (!luarewind_tracking)
+    return false;
+
+  // Called straight from the host, so errors can't be left to reach the
+  // panic handler.
+  bool stepped = false;
+  if (lua_cpcall(L, step_back, &stepped) != 0) {
+    const char* error = lua_tostring(L, -1);
+    SYSTEM_WARN_LOG(
+      "Stopped rewinding, the game can't be restored: %s", error ? error : "?"
+    );
+    lua_pop(L, 1);
+    untrack(L);
+    return false;
+  }
+
+  // Once out of snapshots, the game holds on the oldest one rather than
+  // stepping forward and back again on alternate ticks.
+  return stepped || luarewind_rewinding;
+}
+
+/**
+  Starts snapshotting the given table every tick, or stops if given nil.
+*/
+static int luarewind_track(lua_State* L) {
+  if (!lua_isnil(L, 1))
+    luaL_checktype(L, 1, LUA_TTABLE);
+  lua_settop(L, 1);
+
+  untrack(L);
+  if (lua_isnil(L, 1))
+    return 0;
+
+  // Snapshotting right away reports tables that can't be saved to the game.
+  lua_pushvalue(L, 1);
+  lua_setfield(L, LUA_REGISTRYINDEX, LUAREWIND_REGISTRY);
+  luarewind_tracking = true;
+  lua_pushcfunction(L, snapshot);
+  if (lua_pcall(L, 0, 0, 0) != 0) {
+    untrack(L);
+    return lua_error(L);
+  }
+
+  SYSTEM_LOG("Rewinding is on (hold F8 to rewind)");
+  return 0;
+}
+
+/**
+  Snapshots the tracked table right away, for games that don't use `update()`.
+*/
+static int luarewind_capture_now(lua_State* L) {
+  if (!luarewind_tracking)
+    return luaL_error(L, "Nothing to capture, call rewind.track() first!");
+
+  lua_pushcfunction(L, snapshot);
+  lua_call(L, 0, 0);
+  luarewind_rewinding = false;
+  return 0;
+}
+
+/**
+  Steps back the given number of ticks, or one if not given. Returns how many
+  ticks were actually rewound.
+*/
+static int luarewind_back(lua_State* L) {
+  lua_Integer frames = luaL_optinteger(L, 1, 1);
+
+  lua_Integer rewound = 0;
+  while (rewound < frames && restore(L))
+    rewound++;
+
+  lua_pushinteger(L, rewound);
+  return 1;
+}
+
+/**
+  Returns how many ticks can be rewound.
+*/
+static int luarewind_frames(lua_State* L) {
+  lua_pushinteger(L, (lua_Integer)rewind_frames());
+  return 1;
+}
+
+void luaopen_rewind(lua_State* L) {
+  static const luaL_Reg luarewind_lib[] = {
+    {"back", luarewind_back},
+    {"capture", luarewind_capture_now},
+    {"frames", luarewind_frames},
+    {"track", luarewind_track},
+    {NULL, NULL}
+  };
+
+  luaL_register(L, "rewind", luarewind_lib);
+}
+
+void luarewind_free(void) {
+  luarewind_tracking = false;
+  luarewind_rewinding = false;
+  rewind_free();
+}
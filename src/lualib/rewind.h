@@ -0,0 +1,50 @@
+/**
+  src/lualib/rewind.h
+
+  Written by DoelJavid for V-GAME.
+
+  https://github.com/DoelJavid/v-game
+*/
+
+#ifndef LUALIB_REWIND_H
+#define LUALIB_REWIND_H
+
+#include "../api/audio.h"
+#include "../api/rewind.h"
+#include "../api/trace.h"
+#include "storage.h"
+#include <lauxlib.h>
+#include <lua.h>
+
+// The registry field holding the table `rewind.track()` was given.
+#define LUAREWIND_REGISTRY "vgame.rewind"
+
+/**
+  Snapshots the table the game is tracking, if any, into the rewind buffer.
+  Called once per tick after `update()`. If the table can no longer be saved,
+  a warning is logged and tracking stops.
+*/
+void luarewind_capture(lua_State* L);
+
+/**
+  Restores the tracked table to how it was a tick earlier, for ticks spent
+  rewinding instead of running the game. Once the oldest snapshot is reached,
+  the table is left as it is. Returns false if the game should run this tick
+  instead, because it isn't tracking a table or there was nothing to rewind to
+  when rewinding started. If the snapshot can't be restored, a warning is
+  logged and tracking stops.
+*/
+bool luarewind_step(lua_State* L);
+
+/**
+  Opens the `rewind` library, which lets games and testers step back through
+  the last few seconds of a game.
+*/
+void luaopen_rewind(lua_State* L);
+
+/**
+  Drops every snapshot.
+*/
+void luarewind_free(void);
+
+#endif
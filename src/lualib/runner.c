@@ -0,0 +1,169 @@
+/**
+  src/lualib/runner.c
+
+  Written by DoelJavid for V-GAME.
+
+  https://github.com/DoelJavid/v-game
+*/
+
+#include "runner.h"
+
+#if !defined(_WIN32)
+#include <unistd.h>
+#endif
+
+/**
+  How an instance ended.
+*/
+typedef struct {
+  int status;
+  size_t ticks;
+} runner_result_t;
+
+static runner_args_t runner_args;
+static runner_result_t* runner_results = NULL;
+static atomic_size_t runner_next = 0;
+
+/**
+  Returns how many CPUs the game can run on, or 1 if that's unknown.
+*/
+static size_t cpu_count(void) {
+#if defined(_WIN32)
+  const char* count = getenv("NUMBER_OF_PROCESSORS");
+  long cpus = count ? strtol(count, NULL, 10) : 0;
+#else
+  long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+  return cpus > 0 ? (size_t)cpus : 1;
+}
+
+/**
+  Runs one instance of the game on the calling thread to completion. The
+  thread must not have run a game before.
+*/
+static runner_result_t run_instance(size_t instance) {
+  sys_args_t sys_args = runner_args.sys_args;
+  sys_args.headless = true;
+  sys_args.instance = instance;
+
+  runner_result_t result = {.status = 1};
+  system_init(sys_args);
+  graphics_init(system_get_framebuffer());
+  if (replay_init(NULL, sys_args.replay_input) == 0)
+    result.status = vlua_init(runner_args.game_path, runner_args.lua_args);
+  result.ticks = system_tick();
+
+  replay_free();
+  graphics_free();
+  system_free();
+  return result;
+}
+
+/**
+  Runs the instance pointed to by the given argument on a new thread. Every
+  piece of state the runtime keeps per game is thread-local, so running each
+  instance on a fresh thread starts it the same way a new process would.
+*/
+static int instance_main(void* arg) {
+  size_t index = *(size_t*)arg;
+  runner_results[index] = run_instance(index + 1);
+  return 0;
+}
+
+/**
+  A thread of the pool. Takes the next instance nobody has run yet until there
+  are none left.
+*/
+static int runner_main(void* arg) {
+  (void)arg;
+
+  for (;;) {
+    size_t index = atomic_fetch_add(&runner_next, 1);
+    if (index >= runner_args.instances)
+      break;
+
+    thrd_t thread;
+    if (thrd_create(&thread, instance_main, &index) != thrd_success) {
+      SYSTEM_ERROR_LOG("Failed to start instance %zu!", index + 1);
+      runner_results[index].status = 1;
+      continue;
+    }
+    thrd_join(thread, NULL);
+  }
+
+  return 0;
+}
+
+int runner_run(runner_args_t args) {
+  if (args.instances == 0)
+    return 0;
+
+  // These write to a single file, which every instance would fight over.
+  if (args.sys_args.record_input || args.sys_args.trace_path ||
+      args.sys_args.bench_frames > 0 || args.lua_args.profile_path)
+    SYSTEM_WARN_LOG(
+      "Instances can't record input, be traced, benched or profiled. Ignoring "
+      "those flags."
+    );
+  args.sys_args.record_input = NULL;
+  args.sys_args.trace_path = NULL;
+  args.sys_args.bench_frames = 0;
+  args.sys_args.latency_probe = false;
+  args.lua_args.profile_path = NULL;
+
+  size_t jobs = args.jobs ? args.jobs : cpu_count();
+  if (jobs > args.instances)
+    jobs = args.instances;
+  if (jobs > RUNNER_MAX_JOBS)
+    jobs = RUNNER_MAX_JOBS;
+
+  runner_results = calloc(args.instances, sizeof(runner_result_t));
+  if (!runner_results) {
+    SYSTEM_PANIC_LOG("Out of memory!");
+    return 1;
+  }
+
+  runner_args = args;
+  atomic_store(&runner_next, 0);
+
+  SYSTEM_LOG(
+    "Running %zu instances of %s on %zu threads", args.instances,
+    args.game_path, jobs
+  );
+  double start = system_clock();
+
+  // The calling thread runs instances too, so it isn't left idle.
+  thrd_t threads[RUNNER_MAX_JOBS];
+  size_t started = 0;
+  while (started < jobs - 1 &&
+         thrd_create(&threads[started], runner_main, NULL) == thrd_success)
+    started++;
+  if (started < jobs - 1)
+    SYSTEM_WARN_LOG("Only started %zu of %zu threads.", started + 1, jobs);
+
+  runner_main(NULL);
+  for (size_t i = 0; i < started; i++)
+    thrd_join(threads[i], NULL);
+
+  size_t failed = 0, ticks = 0;
+  for (size_t i = 0; i < args.instances; i++) {
+    ticks += runner_results[i].ticks;
+    if (runner_results[i].status != 0) {
+      SYSTEM_WARN_LOG(
+        "Instance %zu exited with status %d after %zu ticks.", i + 1,
+        runner_results[i].status, runner_results[i].ticks
+      );
+      failed++;
+    }
+  }
+
+  double elapsed = system_clock() - start;
+  SYSTEM_LOG(
+    "Ran %zu instances in %.3fs (%.0f ticks per second), %zu failed",
+    args.instances, elapsed, elapsed > 0.0 ? ticks / elapsed : 0.0, failed
+  );
+
+  free(runner_results);
+  runner_results = NULL;
+  return failed > 0;
+}
@@ -0,0 +1,50 @@
+/**
+  src/lualib/runner.h
+
+  Written by DoelJavid for V-GAME.
+
+  https://github.com/DoelJavid/v-game
+*/
+
+#ifndef LUALIB_RUNNER_H
+#define LUALIB_RUNNER_H
+
+#include "../api/init.h"
+#include "init.h"
+#include <stdatomic.h>
+#include <threads.h>
+
+// The most threads the runner starts, whatever it's asked for.
+#define RUNNER_MAX_JOBS 256
+
+/**
+  Options for running many instances of a game at once.
+*/
+typedef struct {
+  // The game every instance runs.
+  const char* game_path;
+  // How many instances to run.
+  size_t instances;
+  // How many instances run at the same time. If 0, one per CPU.
+  size_t jobs;
+  // The options every instance is started with. Instances always run
+  // headless, and can't record input or be traced or benched.
+  sys_args_t sys_args;
+  // The options every instance's Lua runtime is started with. Instances can't
+  // be profiled.
+  vlua_args_t lua_args;
+} runner_args_t;
+
+/**
+  Runs the given number of headless instances of a game across a pool of
+  threads, each with its own runtime, and waits for all of them to stop. Each
+  instance knows its number through `system_instance()` and has its own saves.
+  Logs a summary once every instance is done. Returns 0 if every instance
+  exited with status 0, and 1 otherwise.
+
+  The logger must be running, and the runner can't be used while a game is
+  running on the calling thread.
+*/
+int runner_run(runner_args_t args);
+
+#endif
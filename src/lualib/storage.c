@@ -0,0 +1,748 @@
+/**
+  src/lualib/storage.c
+
+  Written by DoelJavid for V-GAME.
+
+  https://github.com/DoelJavid/v-game
+*/
+
+#include "storage.h"
+
+// The error thrown for keys that can't name a save.
+#define LUASTORAGE_KEY_ERROR "save keys are made of letters, digits, - and _"
+
+/**
+  The tag byte starting each value in a save.
+*/
+typedef enum {
+  SAVE_NIL,
+  SAVE_FALSE,
+  SAVE_TRUE,
+  SAVE_INTEGER,
+  SAVE_NUMBER,
+  SAVE_STRING,
+  SAVE_STRING_REF,
+  SAVE_TABLE,
+  SAVE_VEC2,
+  SAVE_MAT3,
+  SAVE_OBJECT
+} save_tag_t;
+
+// The fields of `vec2` and `mat3` values, in the order they're saved.
+static const char* const save_vec2_fields[] = {"x", "y"};
+static const char* const save_mat3_fields[] = {
+  "m11", "m12", "m13", "m21", "m22", "m23"
+};
+
+/**
+  The state of a save being written. `strings` is the stack index of a table
+  mapping every string written so far to its index, `vectors` the index of the
+  table of `LUAVVECTOR_REGISTRY` and `class_names` the index of the table of
+  `LUAVBASE_CLASS_NAMES`.
+*/
+typedef struct {
+  char* data;
+  size_t length;
+  size_t capacity;
+  int strings;
+  int vectors;
+  int class_names;
+  size_t string_count;
+  // Set once writing fails, describing why.
+  char error[128];
+} save_writer_t;
+
+/**
+  The state of a save being read. Strings point straight into the save.
+  `vectors` and `classes` are the stack indices of the tables of
+  `LUAVVECTOR_REGISTRY` and `LUAVBASE_CLASSES`.
+*/
+typedef struct {
+  const uint8_t* data;
+  size_t length;
+  size_t offset;
+  int vectors;
+  int classes;
+  const char** strings;
+  size_t* string_lengths;
+  size_t string_count;
+  size_t string_capacity;
+} save_reader_t;
+
+/**
+  Appends the given bytes to the save. Returns false if out of memory.
+*/
+static bool write_bytes(save_writer_t* writer, const void* data, size_t size) {
+  if (writer->length + size > writer->capacity) {
+    size_t capacity = writer->capacity ? writer->capacity * 2 : 256;
+    while (capacity < writer->length + size)
+      capacity *= 2;
+
+    char* buffer = realloc(writer->data, capacity);
+    if (!buffer) {
+      snprintf(
+        writer->error, sizeof(writer->error), "Not enough memory to save!"
+      );
+      return false;
+    }
+    writer->data = buffer;
+    writer->capacity = capacity;
+  }
+
+  memcpy(&writer->data[writer->length], data, size);
+  writer->length += size;
+  return true;
+}
+
+/**
+  Appends a single byte to the save.
+*/
+static bool write_byte(save_writer_t* writer, uint8_t byte) {
+  return write_bytes(writer, &byte, 1);
+}
+
+/**
+  Appends an unsigned LEB128 varint to the save.
+*/
+static bool write_varint(save_writer_t* writer, uint64_t value) {
+  uint8_t bytes[10];
+  size_t length = 0;
+  do {
+    uint8_t byte = value & 0x7f;
+    value >>= 7;
+    bytes[length++] = value ? byte | 0x80 : byte;
+  } while (value);
+
+  return write_bytes(writer, bytes, length);
+}
+
+/**
+  Appends the given number. Whole numbers that doubles represent exactly are
+  written as varints, which takes a byte or two for most scores and counters.
+*/
+static bool write_number(save_writer_t* writer, lua_Number number) {
+  if (number >= -9007199254740992.0 && number <= 9007199254740992.0 &&
+      number == (lua_Number)(int64_t)number) {
+    int64_t integer = (int64_t)number;
+    uint64_t zigzag = ((uint64_t)integer << 1) ^ (uint64_t)(integer >> 63);
+    return write_byte(writer, SAVE_INTEGER) && write_varint(writer, zigzag);
+  }
+
+  uint64_t bits;
+  memcpy(&bits, &number, sizeof(bits));
+  uint8_t bytes[8];
+  for (int i = 0; i < 8; i++)
+    bytes[i] = (bits >> (i * 8)) & 0xff;
+  return write_byte(writer, SAVE_NUMBER) && write_bytes(writer, bytes, 8);
+}
+
+/**
+  Appends the string at the given index, or a reference to it if it was already
+  written.
+*/
+static bool write_string(lua_State* L, save_writer_t* writer, int index) {
+  lua_pushvalue(L, index);
+  lua_rawget(L, writer->strings);
+  if (lua_isnumber(L, -1)) {
+    uint64_t ref = (uint64_t)lua_tonumber(L, -1);
+    lua_pop(L, 1);
+    return write_byte(writer, SAVE_STRING_REF) && write_varint(writer, ref);
+  }
+  lua_pop(L, 1);
+
+  lua_pushvalue(L, index);
+  lua_pushnumber(L, (lua_Number)writer->string_count++);
+  lua_rawset(L, writer->strings);
+
+  size_t length;
+  const char* str = lua_tolstring(L, index, &length);
+  return write_byte(writer, SAVE_STRING) && write_varint(writer, length) &&
+         write_bytes(writer, str, length);
+}
+
+static bool write_value(
+  lua_State* L, save_writer_t* writer, int index, int depth
+);
+
+/**
+  Returns `SAVE_VEC2` or `SAVE_MAT3` if the value at the given index is one,
+  and `SAVE_NIL` otherwise.
+*/
+static save_tag_t vector_tag(lua_State* L, save_writer_t* writer, int index) {
+  static const char* const checks[] = {"is_vec2", "is_mat3"};
+  static const save_tag_t tags[] = {SAVE_VEC2, SAVE_MAT3};
+
+  for (int i = 0; i < 2; i++) {
+    lua_getfield(L, writer->vectors, checks[i]);
+    if (!lua_isfunction(L, -1)) {
+      lua_pop(L, 1);
+      continue;
+    }
+
+    lua_pushvalue(L, index);
+    lua_call(L, 1, 1);
+    bool matches = lua_toboolean(L, -1);
+    lua_pop(L, 1);
+    if (matches)
+      return tags[i];
+  }
+
+  return SAVE_NIL;
+}
+
+/**
+  Appends the `vec2` or `mat3` at the given index, given its tag.
+*/
+static bool write_vector(
+  lua_State* L, save_writer_t* writer, int index, save_tag_t tag
+) {
+  const char* const* fields =
+    tag == SAVE_VEC2 ? save_vec2_fields : save_mat3_fields;
+  int field_count = tag == SAVE_VEC2 ? 2 : 6;
+
+  if (!write_byte(writer, tag))
+    return false;
+
+  for (int i = 0; i < field_count; i++) {
+    lua_getfield(L, index, fields[i]);
+    bool written = write_number(writer, lua_tonumber(L, -1));
+    lua_pop(L, 1);
+    if (!written)
+      return false;
+  }
+
+  return true;
+}
+
+/**
+  Appends the table at the given index. The array part is written as a plain
+  list of values, so arrays don't pay for their keys.
+*/
+static bool write_table(
+  lua_State* L, save_writer_t* writer, int index, int depth
+) {
+  if (depth >= LUASTORAGE_MAX_DEPTH || !lua_checkstack(L, 4)) {
+    snprintf(
+      writer->error, sizeof(writer->error),
+      "Can't save tables nested more than %d levels deep!",
+      LUASTORAGE_MAX_DEPTH
+    );
+    return false;
+  }
+
+  size_t array_length = lua_objlen(L, index);
+  size_t pair_count = 0;
+  lua_pushnil(L);
+  while (lua_next(L, index)) {
+    lua_pop(L, 1);
+    lua_Number key = lua_type(L, -1) == LUA_TNUMBER ? lua_tonumber(L, -1) : 0;
+    if (key < 1 || key > (lua_Number)array_length ||
+        key != (lua_Number)(size_t)key)
+      pair_count++;
+  }
+
+  if (!write_byte(writer, SAVE_TABLE) || !write_varint(writer, array_length))
+    return false;
+
+  for (size_t i = 1; i <= array_length; i++) {
+    lua_rawgeti(L, index, i);
+    bool written = write_value(L, writer, lua_gettop(L), depth + 1);
+    lua_pop(L, 1);
+    if (!written)
+      return false;
+  }
+
+  if (!write_varint(writer, pair_count))
+    return false;
+
+  lua_pushnil(L);
+  while (lua_next(L, index)) {
+    lua_Number key = lua_type(L, -2) == LUA_TNUMBER ? lua_tonumber(L, -2) : 0;
+    if (key >= 1 && key <= (lua_Number)array_length &&
+        key == (lua_Number)(size_t)key) {
+      lua_pop(L, 1);
+      continue;
+    }
+
+    int top = lua_gettop(L);
+    if (!write_value(L, writer, top - 1, depth + 1) ||
+        !write_value(L, writer, top, depth + 1)) {
+      lua_pop(L, 2);
+      return false;
+    }
+    lua_pop(L, 1);
+  }
+
+  return true;
+}
+
+/**
+  Appends the value at the given index, which must be an absolute index.
+  Returns false and sets the writer's error if it can't be saved.
+*/
+static bool write_value(
+  lua_State* L, save_writer_t* writer, int index, int depth
+) {
+  switch (lua_type(L, index)) {
+  case LUA_TNIL:
+    return write_byte(writer, SAVE_NIL);
+
+  case LUA_TBOOLEAN:
+    return write_byte(
+      writer, lua_toboolean(L, index) ? SAVE_TRUE : SAVE_FALSE
+    );
+
+  case LUA_TNUMBER:
+    return write_number(writer, lua_tonumber(L, index));
+
+  case LUA_TSTRING:
+    return write_string(L, writer, index);
+
+  case LUA_TTABLE: {
+    if (!lua_getmetatable(L, index))
+      return write_table(L, writer, index, depth);
+
+    // Instances of classes are saved with the name of their class.
+    lua_rawget(L, writer->class_names);
+    if (lua_type(L, -1) == LUA_TSTRING) {
+      bool written = write_byte(writer, SAVE_OBJECT) &&
+                     write_string(L, writer, lua_gettop(L)) &&
+                     write_table(L, writer, index, depth);
+      lua_pop(L, 1);
+      return written;
+    }
+    lua_pop(L, 1);
+
+    // Without FFI, vectors are tables too.
+    save_tag_t tag = vector_tag(L, writer, index);
+    if (tag != SAVE_NIL)
+      return write_vector(L, writer, index, tag);
+    return write_table(L, writer, index, depth);
+  }
+
+  default: {
+    save_tag_t tag = vector_tag(L, writer, index);
+    if (tag != SAVE_NIL)
+      return write_vector(L, writer, index, tag);
+
+    snprintf(
+      writer->error, sizeof(writer->error), "Can't save a value of type %s!",
+      luaL_typename(L, index)
+    );
+    return false;
+  }
+  }
+}
+
+/**
+  Reads the next byte of the save into `byte`. Returns false if the save has
+  run out.
+*/
+static bool read_byte(save_reader_t* reader, uint8_t* byte) {
+  if (reader->offset >= reader->length)
+    return false;
+
+  *byte = reader->data[reader->offset++];
+  return true;
+}
+
+/**
+  Reads an unsigned LEB128 varint into `value`.
+*/
+static bool read_varint(save_reader_t* reader, uint64_t* value) {
+  uint64_t result = 0;
+  int shift = 0;
+  uint8_t byte;
+
+  do {
+    if (shift > 63 || !read_byte(reader, &byte))
+      return false;
+    result |= (uint64_t)(byte & 0x7f) << shift;
+    shift += 7;
+  } while (byte & 0x80);
+
+  *value = result;
+  return true;
+}
+
+/**
+  Reads a string and pushes it, remembering it for later references.
+*/
+static bool read_string(lua_State* L, save_reader_t* reader) {
+  uint64_t length;
+  if (!read_varint(reader, &length) ||
+      length > reader->length - reader->offset)
+    return false;
+
+  if (reader->string_count == reader->string_capacity) {
+    size_t capacity =
+      reader->string_capacity ? reader->string_capacity * 2 : 32;
+    const char** strings =
+      realloc(reader->strings, capacity * sizeof(const char*));
+    if (!strings)
+      return false;
+    reader->strings = strings;
+
+    size_t* lengths =
+      realloc(reader->string_lengths, capacity * sizeof(size_t));
+    if (!lengths)
+      return false;
+    reader->string_lengths = lengths;
+    reader->string_capacity = capacity;
+  }
+
+  const char* str = (const char*)&reader->data[reader->offset];
+  reader->strings[reader->string_count] = str;
+  reader->string_lengths[reader->string_count++] = length;
+  reader->offset += length;
+
+  lua_pushlstring(L, str, length);
+  return true;
+}
+
+/**
+  Reads the next value and pushes it. Returns false without pushing anything if
+  the save is broken.
+*/
+static bool read_value(lua_State* L, save_reader_t* reader, int depth);
+
+/**
+  Reads the fields of a `vec2` or `mat3`, given its tag, and pushes it.
+*/
+static bool read_vector(
+  lua_State* L, save_reader_t* reader, uint8_t tag, int depth
+) {
+  int field_count = tag == SAVE_VEC2 ? 2 : 6;
+  if (!lua_checkstack(L, field_count + 1))
+    return false;
+
+  // With FFI, the constructor is a callable ctype rather than a function.
+  lua_getfield(L, reader->vectors, tag == SAVE_VEC2 ? "vec2" : "mat3");
+  if (lua_isnil(L, -1)) {
+    lua_pop(L, 1);
+    return false;
+  }
+
+  for (int i = 0; i < field_count; i++) {
+    if (!read_value(L, reader, depth)) {
+      lua_pop(L, i + 1);
+      return false;
+    }
+    if (lua_type(L, -1) != LUA_TNUMBER) {
+      lua_pop(L, i + 2);
+      return false;
+    }
+  }
+
+  lua_call(L, field_count, 1);
+  return true;
+}
+
+/**
+  Reads an instance of a class and pushes it, with its metatable set to the
+  newest class with its name. Instances of classes that don't exist anymore are
+  pushed as plain tables.
+*/
+static bool read_object(lua_State* L, save_reader_t* reader, int depth) {
+  if (!read_value(L, reader, depth))
+    return false;
+  if (lua_type(L, -1) != LUA_TSTRING) {
+    lua_pop(L, 1);
+    return false;
+  }
+
+  if (!read_value(L, reader, depth)) {
+    lua_pop(L, 1);
+    return false;
+  }
+  if (!lua_istable(L, -1)) {
+    lua_pop(L, 2);
+    return false;
+  }
+
+  lua_pushvalue(L, -2);
+  lua_rawget(L, reader->classes);
+  if (lua_istable(L, -1))
+    lua_setmetatable(L, -2);
+  else
+    lua_pop(L, 1);
+
+  lua_remove(L, -2);
+  return true;
+}
+
+static bool read_value(lua_State* L, save_reader_t* reader, int depth) {
+  uint8_t tag;
+  if (!read_byte(reader, &tag))
+    return false;
+
+  switch (tag) {
+  case SAVE_NIL:
+    lua_pushnil(L);
+    return true;
+
+  case SAVE_FALSE:
+  case SAVE_TRUE:
+    lua_pushboolean(L, tag == SAVE_TRUE);
+    return true;
+
+  case SAVE_INTEGER: {
+    uint64_t zigzag;
+    if (!read_varint(reader, &zigzag))
+      return false;
+
+    int64_t integer = (int64_t)(zigzag >> 1) ^ -(int64_t)(zigzag & 1);
+    lua_pushnumber(L, (lua_Number)integer);
+    return true;
+  }
+
+  case SAVE_NUMBER: {
+    if (reader->length - reader->offset < 8)
+      return false;
+
+    uint64_t bits = 0;
+    for (int i = 0; i < 8; i++)
+      bits |= (uint64_t)reader->data[reader->offset + i] << (i * 8);
+    reader->offset += 8;
+
+    lua_Number number;
+    memcpy(&number, &bits, sizeof(number));
+    lua_pushnumber(L, number);
+    return true;
+  }
+
+  case SAVE_STRING:
+    return read_string(L, reader);
+
+  case SAVE_STRING_REF: {
+    uint64_t ref;
+    if (!read_varint(reader, &ref) || ref >= reader->string_count)
+      return false;
+
+    lua_pushlstring(L, reader->strings[ref], reader->string_lengths[ref]);
+    return true;
+  }
+
+  case SAVE_TABLE: {
+    // Every value takes at least a byte, which keeps broken saves from asking
+    // for huge tables.
+    uint64_t array_length;
+    if (depth >= LUASTORAGE_MAX_DEPTH || !lua_checkstack(L, 4) ||
+        !read_varint(reader, &array_length) ||
+        array_length > reader->length - reader->offset)
+      return false;
+
+    lua_createtable(L, (int)array_length, 0);
+    for (uint64_t i = 1; i <= array_length; i++) {
+      if (!read_value(L, reader, depth + 1)) {
+        lua_pop(L, 1);
+        return false;
+      }
+      lua_rawseti(L, -2, (int)i);
+    }
+
+    uint64_t pair_count;
+    if (!read_varint(reader, &pair_count) ||
+        pair_count > (reader->length - reader->offset) / 2) {
+      lua_pop(L, 1);
+      return false;
+    }
+
+    for (uint64_t i = 0; i < pair_count; i++) {
+      if (!read_value(L, reader, depth + 1)) {
+        lua_pop(L, 1);
+        return false;
+      }
+      if (!read_value(L, reader, depth + 1)) {
+        lua_pop(L, 2);
+        return false;
+      }
+
+      // Lua can't have nil or NaN keys.
+      if (lua_isnil(L, -2) ||
+          (lua_type(L, -2) == LUA_TNUMBER &&
+           lua_tonumber(L, -2) != lua_tonumber(L, -2))) {
+        lua_pop(L, 3);
+        return false;
+      }
+      lua_rawset(L, -3);
+    }
+
+    return true;
+  }
+
+  case SAVE_VEC2:
+  case SAVE_MAT3:
+    return read_vector(L, reader, tag, depth);
+
+  case SAVE_OBJECT:
+    return read_object(L, reader, depth);
+
+  default:
+    return false;
+  }
+}
+
+/**
+  Pushes the table in the given registry field, or an empty table if there
+  isn't one, and returns its stack index.
+*/
+static int push_registry_table(lua_State* L, const char* field) {
+  lua_getfield(L, LUA_REGISTRYINDEX, field);
+  if (!lua_istable(L, -1)) {
+    lua_pop(L, 1);
+    lua_newtable(L);
+  }
+  return lua_gettop(L);
+}
+
+/**
+  Writes the value given as the first argument to the writer given as a light
+  userdata as the second. Run through `lua_pcall()` so the save can be freed
+  if any of the Lua calls throw.
+*/
+static int encode_protected(lua_State* L) {
+  save_writer_t* writer = lua_touserdata(L, 2);
+  lua_newtable(L);
+  writer->strings = lua_gettop(L);
+  writer->vectors = push_registry_table(L, LUAVVECTOR_REGISTRY);
+  writer->class_names = push_registry_table(L, LUAVBASE_CLASS_NAMES);
+  bool written = write_bytes(writer, LUASTORAGE_MAGIC, 4) &&
+                 write_byte(writer, LUASTORAGE_VERSION) &&
+                 write_value(L, writer, 1, 0);
+
+  if (!written)
+    return luaL_error(L, "%s", writer->error);
+  return 0;
+}
+
+char* luastorage_encode(lua_State* L, int index, size_t* length) {
+  if (index < 0 && index > LUA_REGISTRYINDEX)
+    index = lua_gettop(L) + index + 1;
+
+  save_writer_t writer = {0};
+  lua_pushcfunction(L, encode_protected);
+  lua_pushvalue(L, index);
+  lua_pushlightuserdata(L, &writer);
+  if (lua_pcall(L, 2, 0, 0) != 0) {
+    free(writer.data);
+    lua_error(L);
+    return NULL;
+  }
+
+  *length = writer.length;
+  return writer.data;
+}
+
+/**
+  Reads a value from the reader given as a light userdata and returns whether
+  it was decoded, followed by the value. Run through `lua_pcall()` so the
+  string index can be freed if any of the Lua calls throw.
+*/
+static int decode_protected(lua_State* L) {
+  save_reader_t* reader = lua_touserdata(L, 1);
+  reader->vectors = push_registry_table(L, LUAVVECTOR_REGISTRY);
+  reader->classes = push_registry_table(L, LUAVBASE_CLASSES);
+
+  const uint8_t* data = reader->data;
+  bool decoded = reader->length > 4 &&
+                 memcmp(data, LUASTORAGE_MAGIC, 4) == 0 &&
+                 data[4] >= LUASTORAGE_MIN_VERSION &&
+                 data[4] <= LUASTORAGE_VERSION &&
+                 read_value(L, reader, 0) && reader->offset == reader->length;
+
+  if (!decoded) {
+    lua_pushboolean(L, 0);
+    return 1;
+  }
+
+  lua_pushboolean(L, 1);
+  lua_insert(L, -2);
+  return 2;
+}
+
+/**
+  Like `luastorage_decode()`, except that errors are left on the stack and their
+  status returned instead of being thrown.
+*/
+static int decode(
+  lua_State* L, const void* data, size_t length, bool* decoded
+) {
+  save_reader_t reader = {.data = data, .length = length, .offset = 5};
+  lua_pushcfunction(L, decode_protected);
+  lua_pushlightuserdata(L, &reader);
+  int status = lua_pcall(L, 1, 2, 0);
+  free(reader.strings);
+  free(reader.string_lengths);
+  if (status != 0)
+    return status;
+
+  *decoded = lua_toboolean(L, -2);
+  if (*decoded)
+    lua_remove(L, -2);
+  else
+    lua_pop(L, 2);
+  return 0;
+}
+
+bool luastorage_decode(lua_State* L, const void* data, size_t length) {
+  bool decoded = false;
+  if (decode(L, data, length, &decoded) != 0)
+    lua_error(L);
+  return decoded;
+}
+
+/**
+  Saves a value under the given key. The save is written on another thread, so
+  this never waits for the disk.
+*/
+static int luastorage_save(lua_State* L) {
+  const char* key = luaL_checkstring(L, 1);
+  luaL_checkany(L, 2);
+  if (!storage_valid_key(key))
+    return luaL_argerror(L, 1, LUASTORAGE_KEY_ERROR);
+
+  size_t length;
+  char* data = luastorage_encode(L, 2, &length);
+  if (!storage_write(key, data, length))
+    SYSTEM_WARN_LOG("Failed to save \"%s\"!", key);
+  return 0;
+}
+
+/**
+  Returns the value saved under the given key, or nil if nothing was saved.
+*/
+static int luastorage_load(lua_State* L) {
+  const char* key = luaL_checkstring(L, 1);
+  if (!storage_valid_key(key))
+    return luaL_argerror(L, 1, LUASTORAGE_KEY_ERROR);
+
+  storage_blob_t blob;
+  if (!storage_read(key, &blob)) {
+    lua_pushnil(L);
+    return 1;
+  }
+
+  bool loaded = false;
+  int status = decode(L, blob.data, blob.length, &loaded);
+  storage_release(&blob);
+  if (status != 0)
+    return lua_error(L);
+
+  if (!loaded) {
+    SYSTEM_WARN_LOG("Save \"%s\" is broken, ignoring it.", key);
+    lua_pushnil(L);
+  }
+
+  return 1;
+}
+
+void luaopen_storage(lua_State* L) {
+  static const luaL_Reg luastorage_lib[] = {
+    {"load", luastorage_load},
+    {"save", luastorage_save},
+    {NULL, NULL}
+  };
+
+  luaL_register(L, "storage", luastorage_lib);
+}
@@ -0,0 +1,63 @@
+/**
+  src/lualib/storage.h
+
+  Written by DoelJavid for V-GAME.
+
+  https://github.com/DoelJavid/v-game
+*/
+
+#ifndef LUALIB_STORAGE_H
+#define LUALIB_STORAGE_H
+
+#include "../api/storage.h"
+#include "vbase.h"
+#include "vvector.h"
+#include <lauxlib.h>
+#include <lua.h>
+#include <stdint.h>
+#include <string.h>
+
+#define LUASTORAGE_MAGIC "VSAV"
+#define LUASTORAGE_VERSION 2
+
+// The oldest version of saves that can still be loaded.
+#define LUASTORAGE_MIN_VERSION 1
+
+// How many levels of nested tables a save can hold.
+#define LUASTORAGE_MAX_DEPTH 64
+
+/**
+  Opens the `storage` library, which saves Lua values between runs.
+
+  A save starts with `LUASTORAGE_MAGIC` and a version byte, followed by a
+  single value. Each value is a tag byte followed by its contents:
+
+  - `nil`, `false` and `true` have no contents.
+  - Integers are a zigzag LEB128 varint, and other numbers are a little-endian
+    double.
+  - Strings are a varint length followed by their bytes. Every string gets the
+    next index in a table of strings, so repeated strings are written as a
+    reference holding the varint index instead.
+  - Tables are a varint length followed by the values of their array part, then
+    a varint count followed by every other key and value.
+  - `vec2` and `mat3` values are their fields as numbers, in order.
+  - Instances of classes made by `class()` are the class name as a string
+    followed by the instance as a table. Loading one sets its metatable to the
+    newest class with that name, if there is one.
+*/
+void luaopen_storage(lua_State* L);
+
+/**
+  Encodes the value at the given index in the save format and returns it,
+  allocated with `malloc()`, writing its size to `length`. Throws a Lua error
+  if the value can't be saved or memory runs out, without leaking the save.
+*/
+char* luastorage_encode(lua_State* L, int index, size_t* length);
+
+/**
+  Decodes a value in the save format and pushes it. Returns false without
+  pushing anything if the data is broken, and throws if memory runs out.
+*/
+bool luastorage_decode(lua_State* L, const void* data, size_t length);
+
+#endif
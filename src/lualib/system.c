@@ -1,17 +1,55 @@
 #include "system.h"
 
+// The address of this is the error thrown to unwind back to the host.
+static char luasystem_unwind_sentinel;
+
 /**
-  Prints all data passed from Lua to the console.
+  Logs every value passed from Lua at the given level. Strings, numbers,
+  booleans and nil are logged as-is, and only other values go through
+  `tostring()`.
 */
-static int luasystem_log(lua_State* L) {
+static void log_values(lua_State* L, logger_level_t level) {
+  if (!logger_enabled(level))
+    return;
+
   int nargs = lua_gettop(L);
   for (int i = 1; i <= nargs; i++) {
-    lua_pushcfunction(L, luavbase_tostring);
-    lua_pushvalue(L, i);
-    lua_call(L, 1, 1);
-    SYSTEM_LOG(lua_tostring(L, -1));
-    lua_pop(L, 1);
+    size_t length;
+    switch (lua_type(L, i)) {
+      case LUA_TSTRING:
+      case LUA_TNUMBER: {
+        // Numbers are converted in place, which is fine for arguments.
+        const char* str = lua_tolstring(L, i, &length);
+        logger_message(level, str, length);
+        break;
+      }
+      case LUA_TBOOLEAN:
+        if (lua_toboolean(L, i))
+          logger_message(level, "true", 4);
+        else
+          logger_message(level, "false", 5);
+        break;
+      case LUA_TNIL:
+        logger_message(level, "nil", 3);
+        break;
+      default: {
+        lua_pushcfunction(L, luavbase_tostring);
+        lua_pushvalue(L, i);
+        lua_call(L, 1, 1);
+        const char* str = lua_tolstring(L, -1, &length);
+        logger_message(level, str, length);
+        lua_pop(L, 1);
+        break;
+      }
+    }
   }
+}
+
+/**
+  Prints all data passed from Lua to the console.
+*/
+static int luasystem_log(lua_State* L) {
+  log_values(L, LOGGER_LEVEL_INFO);
   return 0;
 }
 
@@ -19,14 +57,7 @@ static int luasystem_log(lua_State* L) {
   Prints all data passed from Lua to the console formatted as a warning.
 */
 static int luasystem_warn(lua_State* L) {
-  int nargs = lua_gettop(L);
-  for (int i = 1; i <= nargs; i++) {
-    lua_pushcfunction(L, luavbase_tostring);
-    lua_pushvalue(L, i);
-    lua_call(L, 1, 1);
-    SYSTEM_WARN_LOG(lua_tostring(L, -1));
-    lua_pop(L, 1);
-  }
+  log_values(L, LOGGER_LEVEL_WARNING);
   return 0;
 }
 
@@ -34,14 +65,7 @@ static int luasystem_warn(lua_State* L) {
   Prints all data passed from Lua to the console formatted as an error message.
 */
 static int luasystem_error(lua_State* L) {
-  int nargs = lua_gettop(L);
-  for (int i = 1; i <= nargs; i++) {
-    lua_pushcfunction(L, luavbase_tostring);
-    lua_pushvalue(L, i);
-    lua_call(L, 1, 1);
-    SYSTEM_ERROR_LOG(lua_tostring(L, -1));
-    lua_pop(L, 1);
-  }
+  log_values(L, LOGGER_LEVEL_ERROR);
   return 0;
 }
 
@@ -59,11 +83,11 @@ static int luasystem_panic(lua_State* L) {
 }
 
 /**
-  Exits the program with the given exit code.
+  Stops the game with the given exit code.
 */
 static int luasystem_exit(lua_State* L) {
-  exit(luaL_optint(L, 1, 0));
-  return 0;
+  system_quit(luaL_optint(L, 1, 0));
+  return luasystem_unwind(L);
 }
 
 /**
@@ -75,6 +99,23 @@ static int luasystem_tick(lua_State* L) {
   return 1;
 }
 
+/**
+  Returns which instance of the game this is when running many at once with
+  `--instances`, or 0 otherwise.
+*/
+static int luasystem_instance(lua_State* L) {
+  lua_pushinteger(L, (lua_Integer)system_instance());
+  return 1;
+}
+
+/**
+  Returns a precise timestamp in seconds, for timing code.
+*/
+static int luasystem_clock(lua_State* L) {
+  lua_pushnumber(L, system_clock());
+  return 1;
+}
+
 /**
   Returns the current time in the form of a unix timestamp.
 */
@@ -83,6 +124,125 @@ static int luasystem_time(lua_State* L) {
   return 1;
 }
 
+/**
+  Pushes a table summarizing a set of samples, with every value multiplied by
+  the given scale to convert it to the unit Lua sees.
+*/
+static void push_summary(lua_State* L, stats_summary_t summary, double scale) {
+  lua_createtable(L, 0, 6);
+  lua_pushnumber(L, summary.mean * scale);
+  lua_setfield(L, -2, "Mean");
+  lua_pushnumber(L, summary.p50 * scale);
+  lua_setfield(L, -2, "P50");
+  lua_pushnumber(L, summary.p95 * scale);
+  lua_setfield(L, -2, "P95");
+  lua_pushnumber(L, summary.p99 * scale);
+  lua_setfield(L, -2, "P99");
+  lua_pushnumber(L, summary.max * scale);
+  lua_setfield(L, -2, "Max");
+  lua_pushinteger(L, summary.count);
+  lua_setfield(L, -2, "Count");
+}
+
+/**
+  Returns a table with timing statistics about recent frames.
+*/
+static int luasystem_stats(lua_State* L) {
+  system_stats_t stats = system_stats();
+
+  lua_createtable(L, 0, 5);
+  push_summary(L, stats.frame_time, 1000);
+  lua_setfield(L, -2, "FrameTime");
+  push_summary(L, stats.lateness, 1000);
+  lua_setfield(L, -2, "Lateness");
+  push_summary(L, stats.gc_time, 1000);
+  lua_setfield(L, -2, "GC");
+  push_summary(L, stats.heap_size, 1.0 / 1024);
+  lua_setfield(L, -2, "Heap");
+  lua_pushinteger(L, stats.skipped_frames);
+  lua_setfield(L, -2, "Skipped");
+  return 1;
+}
+
+/**
+  Begins a named zone on the trace timeline when given a name, or ends the most
+  recently begun zone when called without one. Does nothing unless tracing.
+*/
+static int luasystem_zone(lua_State* L) {
+  static INSTANCE_LOCAL struct {
+    const char* name;
+    double start;
+  } zones[LUASYSTEM_MAX_ZONES];
+  static INSTANCE_LOCAL int depth = 0;
+
+  if (lua_isnoneornil(L, 1)) {
+    if (depth > 0) {
+      depth--;
+      trace_end(zones[depth].name, zones[depth].start);
+    }
+    return 0;
+  }
+
+  const char* name = luaL_checkstring(L, 1);
+  if (!trace_active())
+    return 0;
+  if (depth == LUASYSTEM_MAX_ZONES)
+    return luaL_error(L, "too many nested zones");
+
+  zones[depth].name = trace_intern(name);
+  zones[depth].start = trace_begin();
+  depth++;
+  return 0;
+}
+
+void luasystem_push_unwind(lua_State* L) {
+  lua_pushlightuserdata(L, &luasystem_unwind_sentinel);
+}
+
+int luasystem_unwind(lua_State* L) {
+  luasystem_push_unwind(L);
+  return lua_error(L);
+}
+
+bool luasystem_unwinding(lua_State* L, int index) {
+  return lua_touserdata(L, index) == &luasystem_unwind_sentinel;
+}
+
+/**
+  Returns a table describing how much memory the game is using.
+*/
+static int luasystem_memory(lua_State* L) {
+  pool_stats_t stats = pool_stats();
+  if (!pool_active()) {
+    stats.used = lua_gc(L, LUA_GCCOUNT, 0) * 1024 + lua_gc(L, LUA_GCCOUNTB, 0);
+    stats.peak = stats.used;
+  }
+
+  lua_createtable(L, 0, 5);
+  lua_pushinteger(L, stats.used);
+  lua_setfield(L, -2, "Used");
+  lua_pushinteger(L, stats.peak);
+  lua_setfield(L, -2, "Peak");
+  lua_pushinteger(L, stats.cap);
+  lua_setfield(L, -2, "Cap");
+  lua_pushinteger(L, stats.reserved);
+  lua_setfield(L, -2, "Reserved");
+
+  lua_createtable(L, pool_active() ? POOL_CLASSES + 1 : 0, 0);
+  for (int i = 0; pool_active() && i <= POOL_CLASSES; i++) {
+    lua_createtable(L, 0, 3);
+    lua_pushinteger(L, stats.classes[i].size);
+    lua_setfield(L, -2, "Size");
+    lua_pushinteger(L, stats.classes[i].count);
+    lua_setfield(L, -2, "Count");
+    lua_pushinteger(L, stats.classes[i].bytes);
+    lua_setfield(L, -2, "Bytes");
+    lua_rawseti(L, -2, i + 1);
+  }
+  lua_setfield(L, -2, "Classes");
+  return 1;
+}
+
 void luaopen_system(lua_State* L) {
   static const luaL_Reg luasystem_lib[] = {
     {"log", luasystem_log},
@@ -92,6 +252,11 @@ void luaopen_system(lua_State* L) {
     {"exit", luasystem_exit},
     {"tick", luasystem_tick},
     {"time", luasystem_time},
+    {"clock", luasystem_clock},
+    {"instance", luasystem_instance},
+    {"stats", luasystem_stats},
+    {"memory", luasystem_memory},
+    {"zone", luasystem_zone},
     {NULL, NULL}
   };
 
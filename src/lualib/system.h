@@ -4,10 +4,34 @@
 #define LUALIB_SYSTEM_H
 
 #include "../api/system.h"
+#include "../api/trace.h"
+#include "pool.h"
 #include "vbase.h"
 #include <lua.h>
 #include <lauxlib.h>
 
+// How deeply `system.zone()` calls can be nested.
+#define LUASYSTEM_MAX_ZONES 32
+
+/**
+  Pushes the error thrown by `luasystem_unwind()`, for code that needs to
+  recognize it without calling into C.
+*/
+void luasystem_push_unwind(lua_State* L);
+
+/**
+  Unwinds the Lua stack all the way back to the host by throwing an error that
+  `pcall()` won't catch. Used to stop the game once `system_running()` returns
+  false, instead of exiting from deep inside a Lua call.
+*/
+int luasystem_unwind(lua_State* L);
+
+/**
+  Returns true if the value at the given index is the error thrown by
+  `luasystem_unwind()`.
+*/
+bool luasystem_unwinding(lua_State* L, int index);
+
 /**
   Activates the `system` library within the given lua state.
 */
@@ -7,6 +7,8 @@
 */
 
 #include "vbase.h"
+#include "native.h"
+#include "system.h"
 
 /**
   Tests if the given condition is truthy, and throws an error if it's falsy. An
@@ -20,373 +22,249 @@ static int luavbase_assert(lua_State* L) {
 }
 
 /**
-  Tests if the type name provided in the second argument matches the type of
-  the first argument. If they don't match, this function will throw a fatal
-  error. This function is almost equivalent to `assert(type(value) == type)`
-  except for the message.
+  Like check, except that it ignores the `__type` field within tables.
 */
-static int luavbase_check(lua_State* L) {
+static int luavbase_rawcheck(lua_State* L) {
   luaL_checkany(L, 1);
   const char* test_type = luaL_checkstring(L, 2);
-  const char* real_type_name = lua_typename(L, lua_type(L, 1));
-  const int real_type_id = lua_type(L, 1);
-
-  // Push the typename of the value to the stack.
-  lua_pushstring(L, real_type_name);
-
-  if (real_type_id == LUA_TTABLE) {
-    // Push the table's type field to the stack. If it's a string, compare it
-    // with the real type name.
-    lua_getfield(L, 1, "__type");
-
-    if (lua_isstring(L, -1) && lua_equal(L, -1, -2)) {
-      lua_pushvalue(L, 1);
-      return 1;
-    }
-
-    // The type field isn't a string or doesn't match. Pop the `__type` field
-    // from the stack.
-    lua_pop(L, 1);
-  }
+  const char* real_type = lua_typename(L, lua_type(L, 1));
 
+  lua_pushstring(L, real_type);
   lua_pushstring(L, test_type);
-  if (lua_equal(L, -1, -2)) {
-    lua_pushvalue(L, 1);
-    return 1;
-  }
+  if (lua_equal(L, -2, -1))
+    return 0;
 
-  return luaL_error(L, "Expected %s, but got %s!", real_type_name, test_type);
+  return luaL_error(L, "Expected %s, but got %s!", test_type, real_type);
 }
 
-/**
-  The iterator function used as a return value of `ipairs()`.
-*/
-static int luavbase_ipairs_next(lua_State* L) {
-  int idx = luaL_checkint(L, 2) + 1;
-
-  if (lua_istable(L, 1)) {
-    lua_pushinteger(L, idx);
-    lua_rawgeti(L, 1, idx);
-    return (lua_isnil(L, -1)) ? 0 : 2;
-  } else if (lua_isstring(L, 1)) {
-    size_t str_length;
-    const char* str = lua_tolstring(L, 1, &str_length);
-
-    if (idx <= str_length) {
-      lua_pushinteger(L, idx);
-      lua_pushlstring(L, &str[idx - 1], 1);
-      return 2;
-    }
-    return 0;
-  }
-  return luaL_typerror(L, 1, "table or string");
+static int luavbase_rawtype(lua_State* L) {
+  luaL_checkany(L, 1);
+  lua_pushstring(L, lua_typename(L, lua_type(L, 1)));
+  return 1;
 }
 
 /**
-  Takes an iterable and returns three values: an iterator function, the table
-  itself, and 0. If used in a `for..in` loop, the returned iterator function
-  will iterate through the table starting at index 1 up to the first occurance
-  of `nil`.
+  A growing buffer holding the string built by `table_to_string()`.
 */
-static int luavbase_ipairs(lua_State* L) {
-  int type = lua_type(L, 1);
-  if (type == LUA_TTABLE || type == LUA_TSTRING) {
-    lua_pushcfunction(L, luavbase_ipairs_next);
-    lua_pushvalue(L, 1);
-    lua_pushinteger(L, 0);
-    return 3;
-  }
-  return luaL_typerror(L, 1, "table or string");
-}
+typedef struct {
+  char* data;
+  size_t length;
+  size_t capacity;
+  // Set if memory ran out or the size limit was reached.
+  bool full;
+} tostring_buffer_t;
 
 /**
-  Returns the next key-value pair within the given iterable. This function can
-  be used to iterate through a table without using `pairs()` or `ipairs()`
-  directly, and can be used to write custom iterators. Just keep in mind that
-  `next()` will traverse tables in an unpredictable order!
+  Appends the given bytes to the buffer, growing it as needed. Once the buffer
+  is full, everything else is dropped.
 */
-static int luavbase_next(lua_State* L) {
-  if (lua_istable(L, 1)) {
-    lua_settop(L, 2);
-    if (lua_next(L, 1))
-      return 2;
-
-    lua_pushnil(L);
-    return 1;
-  } else if (lua_isstring(L, 1)) {
-    size_t str_length;
-    const char* str = lua_tolstring(L, 1, &str_length);
-    int idx = lua_tointeger(L, 2) + 1;
-
-    if (idx <= str_length) {
-      lua_pushinteger(L, idx);
-      lua_pushlstring(L, &str[idx - 1], 1);
-      return 2;
+static void buffer_add(tostring_buffer_t* buffer, const char* str, size_t len) {
+  if (buffer->full)
+    return;
+
+  if (buffer->length + len > LUAVBASE_TOSTRING_MAX_SIZE) {
+    buffer->full = true;
+    return;
+  }
+
+  if (buffer->length + len > buffer->capacity) {
+    size_t capacity = buffer->capacity ? buffer->capacity * 2 : 256;
+    while (capacity < buffer->length + len)
+      capacity *= 2;
+
+    char* data = realloc(buffer->data, capacity);
+    if (!data) {
+      buffer->full = true;
+      return;
     }
-    return 0;
+    buffer->data = data;
+    buffer->capacity = capacity;
   }
-  return luaL_typerror(L, 1, "table or string");
+
+  memcpy(&buffer->data[buffer->length], str, len);
+  buffer->length += len;
 }
 
 /**
-  Takes an iterable value and returns three values: the `next()` function, the
-  given iterable, and nil. If used in a `for..in` loop, The returned iterator
-  function will iterate through all key-value pairs in a table in an
-  unpredictable order.
+  Appends a null-terminated string to the buffer.
 */
-static int luavbase_pairs(lua_State* L) {
-  int type = lua_type(L, 1);
-  if (type == LUA_TTABLE || type == LUA_TSTRING) {
-    lua_pushcfunction(L, luavbase_next);
-    lua_pushvalue(L, 1);
-    lua_pushnil(L);
-    return 3;
-  }
-  return luaL_typerror(L, 1, "table or string");
+static void buffer_add_string(tostring_buffer_t* buffer, const char* str) {
+  buffer_add(buffer, str, strlen(str));
 }
 
 /**
-  Calls the given function in protected mode, preventing any fatal errors
-  thrown by the function from crashing the program. Pretty much the same as
-  Lua 5.1's source.
-
-  https://www.lua.org/source/5.1/lbaselib.c.html#luaB_pcall
+  Appends a number to the buffer, formatted like Lua formats numbers.
 */
-static int luavbase_pcall(lua_State* L) {
-  luaL_checkany(L, 1);
-  bool status = lua_pcall(L, lua_gettop(L) - 1, LUA_MULTRET, 0);
-  lua_pushboolean(L, status == 0);
-  lua_insert(L, 1);
-  return lua_gettop(L);
+static void buffer_add_number(tostring_buffer_t* buffer, lua_Number number) {
+  char str[LUAI_MAXNUMBER2STR];
+  buffer_add(buffer, str, lua_number2str(str, number));
 }
 
 /**
-  Like check, except that it ignores the `__type` field within tables.
+  Appends two spaces of indentation per level of depth.
 */
-static int luavbase_rawcheck(lua_State* L) {
-  luaL_checkany(L, 1);
-  const char* test_type = luaL_checkstring(L, 2);
-  const char* real_type = lua_typename(L, lua_type(L, 1));
-
-  lua_pushstring(L, real_type);
-  lua_pushstring(L, test_type);
-  if (lua_equal(L, -2, -1))
-    return 0;
-
-  return luaL_error(L, "Expected %s, but got %s!", test_type, real_type);
-}
-
-static int luavbase_rawtype(lua_State* L) {
-  luaL_checkany(L, 1);
-  lua_pushstring(L, lua_typename(L, lua_type(L, 1)));
-  return 1;
+static void buffer_indent(tostring_buffer_t* buffer, int depth) {
+  for (int i = 0; i < depth; i++)
+    buffer_add(buffer, "  ", 2);
 }
 
 /**
-  Returns the type of the given value in the form of a string. Unlike the
-  traditional `type()` function, this function supports a special case for
-  tables that have a `__type` field, where it will return `table.__type` if
-  it's a string.
+  Appends the value at the given index, unless it's a table that should be
+  expanded. Tables that were already written are named `@self` if they're the
+  table being converted and `@table` otherwise.
 */
-static int luavbase_type(lua_State* L) {
-  luaL_checkany(L, 1);
+static void buffer_add_value(
+  lua_State* L, tostring_buffer_t* buffer, int index, int root
+) {
+  switch (lua_type(L, index)) {
+  case LUA_TNUMBER:
+    buffer_add_number(buffer, lua_tonumber(L, index));
+    break;
 
-  if (lua_type(L, 1) == LUA_TTABLE) {
-    lua_pushstring(L, "__type");
-    lua_rawget(L, 1);
+  case LUA_TSTRING: {
+    size_t length;
+    const char* str = lua_tolstring(L, index, &length);
+    buffer_add(buffer, "\"", 1);
+    buffer_add(buffer, str, length);
+    buffer_add(buffer, "\"", 1);
+  } break;
 
-    int custom_table_type = lua_type(L, -1);
-    if (custom_table_type == LUA_TSTRING) {
-      return 1;
-    } else if (custom_table_type != LUA_TNIL) {
-      return luaL_error(L, "Invalid table type!");
-    }
-  }
+  case LUA_TBOOLEAN:
+    buffer_add_string(buffer, lua_toboolean(L, index) ? "true" : "false");
+    break;
 
-  lua_pushstring(L, luaL_typename(L, 1));
-  return 1;
+  case LUA_TTABLE:
+    buffer_add_string(
+      buffer, lua_rawequal(L, index, root) ? "@self" : "@table"
+    );
+    break;
+
+  default:
+    buffer_add(buffer, "@", 1);
+    buffer_add_string(buffer, luaL_typename(L, index));
+    break;
+  }
 }
 
 /**
-  A helper function used by the default logic of `tostring()` to convert table
-  values to strings.
+  Converts the given table to a string listing its contents, nested tables
+  included. Works through nested tables with an explicit stack of
+  `(table, key)` pairs on the Lua stack instead of recursing, and keeps a set
+  of the tables it has written so repeated and recursive tables are only
+  written once. Tables nested deeper than `LUAVBASE_TOSTRING_MAX_DEPTH` are
+  written as `{...}`, and the string is cut short with `...` once it reaches
+  `LUAVBASE_TOSTRING_MAX_SIZE` bytes.
+
+  Expects the table as the first argument and the buffer as a light userdata
+  as the second, and is run through `lua_pcall()` so the buffer can be freed
+  if any of the Lua calls throw.
 */
-static int luautil_table_to_string(lua_State* L) {
-  luaL_checktype(L, 1, LUA_TTABLE);
-
-  // luaL_buffinit will immediately effect the stack, so we should call this
-  // first before doing anything else with the stack.
-  luaL_Buffer table_string;
-  luaL_buffinit(L, &table_string);
-
-  // The ignore list should be of the type `table` or `nil`.
-  int arg_two_type = lua_type(L, 2);
-  if (arg_two_type == LUA_TNONE || arg_two_type == LUA_TNIL) {
-    // Create a new table with the value.
-    lua_createtable(L, 2, 0);
-  } else if (arg_two_type == LUA_TTABLE) {
-    // Push the currently provided ignore list to the stack.
-    lua_pushvalue(L, 2);
-  } else
-    // Hopefully, if all things go well, this function shouldn't throw.
-    return luaL_error(L, "Expected table or nil!");
-
-  // Insert the currently passed table to the ignore list.
-  lua_pushvalue(L, 1);
-  lua_rawseti(L, -2, lua_objlen(L, -2) + 1);
-
-  bool first_value = true;
-  size_t current_array_index = 1;
-  int tab_offset = lua_objlen(L, -1);
-
-  // Iterate through all the keys of the table and construct a full string
-  // using Lua.
-  luaL_addstring(&table_string, "{\n");
+static int table_to_string_protected(lua_State* L) {
+  luaL_checkstack(
+    L, LUAVBASE_TOSTRING_MAX_DEPTH * 2 + 8, "table nested too deeply"
+  );
+
+  tostring_buffer_t* buffer = lua_touserdata(L, 2);
+  lua_Integer next_index[LUAVBASE_TOSTRING_MAX_DEPTH + 1];
+  bool first[LUAVBASE_TOSTRING_MAX_DEPTH + 1];
+
+  int root = 1;
+  lua_newtable(L);
+  int visited = lua_gettop(L);
+  lua_pushvalue(L, root);
+  lua_pushboolean(L, 1);
+  lua_rawset(L, visited);
+
+  // Each level of depth has its table and current key on the stack.
+  int depth = 1;
+  next_index[depth] = 1;
+  first[depth] = true;
+  lua_pushvalue(L, root);
   lua_pushnil(L);
-  while (lua_next(L, 1)) {
-    // After the call to `lua_next()`:
-    // * The key should be located at stack offset -2.
-    // * The value should be located at stack offset -1.
-
-    // Account for the first value within the table.
-    if (first_value)
-      first_value = false;
-    else
-      luaL_addstring(&table_string, ",\n");
-
-    // Add padding based on tab offset.
-    for (int i = 0; i < tab_offset; i++)
-      luaL_addstring(&table_string, "  ");
-
-    // Add the key to the table string.
-    //
-    // In theory, the number indexes should occure in the order they're
-    // declared. If they don't appear in array order, they should be
-    // treated like dictionary keys.
-    if (lua_isnumber(L, -2) && lua_tointeger(L, -2) == current_array_index)
-      current_array_index++;
-    else {
-      int key_type = lua_type(L, -2);
-
-      luaL_addstring(&table_string, "[");
-
-      switch (key_type) {
-      case LUA_TNUMBER:
-        // `lua_tostring()` will convert the number in the stack to a string,
-        // throwing off `lua_next()`. We need to create a duplicate.
-        lua_pushvalue(L, -2);
-        luaL_addstring(&table_string, lua_tostring(L, -1));
-        lua_pop(L, 1);
-        break;
-
-      case LUA_TSTRING:
-        luaL_addstring(&table_string, "\"");
-        luaL_addstring(&table_string, lua_tostring(L, -2));
-        luaL_addstring(&table_string, "\"");
-        break;
-
-      case LUA_TBOOLEAN:
-        luaL_addstring(&table_string, lua_toboolean(L, -2) ? "true" : "false");
-        break;
-
-      case LUA_TTABLE:
-        // Get the first value in the array of reoccuring tables. If it's equal
-        // to the key, then refer to that key as "self". Otherwise, name the
-        // key like any other value.
-        lua_rawgeti(L, -4, 1);
-        if (lua_equal(L, -3, -1))
-          luaL_addstring(&table_string, "@self");
-        else
-          luaL_addstring(&table_string, "@table");
-        lua_pop(L, 1);
-        break;
-
-      case LUA_TFUNCTION:
-        luaL_addstring(&table_string, "@function");
-        break;
-
-      default:
-        break;
+  buffer_add(buffer, "{", 1);
+
+  while (depth > 0 && !buffer->full) {
+    if (!lua_next(L, -2)) {
+      lua_pop(L, 1);
+      if (!first[depth]) {
+        buffer_add(buffer, "\n", 1);
+        buffer_indent(buffer, depth - 1);
       }
-
-      luaL_addstring(&table_string, "] = ");
+      buffer_add(buffer, "}", 1);
+      depth--;
+      continue;
     }
 
-    // We should avoid calling `tostring` on tables that were already indexed
-    // so we won't start an infinite loop.
-    switch (lua_type(L, -1)) {
-    case LUA_TTABLE:
-      bool duplicate_table = false;
-
-      lua_pushnil(L);
-      while (lua_next(L, -4)) {
-        if (lua_rawequal(L, -1, -3)) {
-          duplicate_table = true;
-          lua_pop(L, 2); // Pop both key and value. We're done here.
-          break;
-        }
-
-        lua_pop(L, 1);
-      }
+    buffer_add_string(buffer, first[depth] ? "\n" : ",\n");
+    buffer_indent(buffer, depth);
+    first[depth] = false;
 
-      if (duplicate_table) {
-        lua_rawgeti(L, 2, 1);
-        if (lua_equal(L, -2, -1))
-          luaL_addstring(&table_string, "@self");
-        else {
-          luaL_addstring(&table_string, "@table");
-        }
-        lua_pop(L, 1);
-      } else {
-        // Call `luautil_table_to_string()` recursively to get the table value as a
-        // string.
+    // Keys counting up from 1 are the array part, which is written without
+    // keys.
+    if (lua_type(L, -2) == LUA_TNUMBER &&
+        lua_tonumber(L, -2) == (lua_Number)next_index[depth]) {
+      next_index[depth]++;
+    } else {
+      buffer_add(buffer, "[", 1);
+      buffer_add_value(L, buffer, -2, root);
+      buffer_add(buffer, "] = ", 4);
+    }
 
-        lua_pushcfunction(L, luautil_table_to_string);
-        lua_pushvalue(L, -2);
-        lua_pushvalue(L, -5);
-        lua_call(L, 2, 1);
+    if (lua_istable(L, -1)) {
+      lua_pushvalue(L, -1);
+      lua_rawget(L, visited);
+      bool seen = lua_toboolean(L, -1);
+      lua_pop(L, 1);
 
-        // Add that string to the result buffer.
-        luaL_addstring(&table_string, lua_tostring(L, -1));
+      if (!seen && depth == LUAVBASE_TOSTRING_MAX_DEPTH) {
+        buffer_add(buffer, "{...}", 5);
         lua_pop(L, 1);
+        continue;
       }
-      break;
-    case LUA_TSTRING:
-      // In the case of a string, we need to add quotation marks around the
-      // value to denote it as a string.
-      lua_pushcfunction(L, luavbase_tostring);
-      lua_insert(L, -2);
-      lua_call(L, 1, 1);
-      luaL_addstring(&table_string, "\"");
-      luaL_addstring(&table_string, lua_tostring(L, -1));
-      luaL_addstring(&table_string, "\"");
-      break;
 
-    default:
-      // For all other values, recursively call `luavbase_tostring()`.
-      lua_pushcfunction(L, luavbase_tostring);
-      lua_insert(L, -2);
-      lua_call(L, 1, 1);
-      luaL_addstring(&table_string, lua_tostring(L, -1));
-      break;
+      if (!seen) {
+        lua_pushvalue(L, -1);
+        lua_pushboolean(L, 1);
+        lua_rawset(L, visited);
+
+        // The value becomes the table of the next level.
+        depth++;
+        next_index[depth] = 1;
+        first[depth] = true;
+        lua_pushnil(L);
+        buffer_add(buffer, "{", 1);
+        continue;
+      }
     }
 
-    // Pop the current value out of the stack to continue iterating through the
-    // Lua table.
+    buffer_add_value(L, buffer, -1, root);
     lua_pop(L, 1);
   }
 
-  // Add the closing bracket to the result string and push the result to the
-  // stack. Finally, return this value.
-  luaL_addstring(&table_string, "\n");
-  for (int i = 0; i < tab_offset - 1; i++)
-      luaL_addstring(&table_string, "  ");
-  luaL_addstring(&table_string, "}");
-
-  luaL_pushresult(&table_string);
+  lua_settop(L, root);
+  lua_pushlstring(L, buffer->data ? buffer->data : "", buffer->length);
+  if (buffer->full) {
+    lua_pushliteral(L, "...");
+    lua_concat(L, 2);
+  }
   return 1;
-  // All this programming hurts your head, doesn't it? My head hurts after
-  // writing this function!
+}
+
+/**
+  Pushes the string form of the table at the given index. See
+  `table_to_string_protected()`.
+*/
+static void table_to_string(lua_State* L, int index) {
+  tostring_buffer_t buffer = {0};
+
+  lua_pushvalue(L, index);
+  lua_pushcfunction(L, table_to_string_protected);
+  lua_insert(L, -2);
+  lua_pushlightuserdata(L, &buffer);
+  int status = lua_pcall(L, 2, 1, 0);
+  free(buffer.data);
+  if (status)
+    lua_error(L);
 }
 
 int luavbase_tostring(lua_State* L) {
@@ -412,9 +290,7 @@ int luavbase_tostring(lua_State* L) {
       lua_insert(L, -2);
       lua_call(L, 1, 1);
     } else if (lua_isnil(L, -1)) {
-      lua_pushcfunction(L, luautil_table_to_string);
-      lua_pushvalue(L, 1);
-      lua_call(L, 1, 1);
+      table_to_string(L, 1);
     } else {
       return luaL_error(L, "Expected `__tostring` to be a function or nil!");
     }
@@ -500,51 +376,198 @@ static int luavbase_tonumber(lua_State* L) {
 */
 static int luavbase_sleep(lua_State* L) {
   for (int frames = luaL_checkint(L, 1); frames > 0; frames--)
-    system_interrupt();
+    if (!system_interrupt())
+      return luasystem_unwind(L);
   return 0;
 }
 
 /**
-  Unpacks all the contents of the given lua array, going from the given start
-  index (or 1 if no start index is provided), and the given end index (or the
-  end of the array if no end index is given). This value returns the result in
-  the form of a tuple.
+  The base functions games call in their hottest loops, written in Lua on top
+  of Lua's own builtins, along with `class()` and the type checks that
+  understand it. LuaJIT can compile builtins like `ipairs()` and `next()` into
+  traces, but a call to any other C function aborts the trace, so these only
+  fall back to C for the rare values the builtins can't handle.
+
+  Receives the native libraries, the error unwinding the runtime, and the C
+  versions of `tostring()` and `tonumber()`.
 */
-static int luavbase_unpack(lua_State* L) {
-  luaL_checktype(L, 1, LUA_TTABLE);
-  int start_index = luaL_optint(L, 2, 1);
-  int end_index = luaL_optint(L, 3, lua_objlen(L, 1));
-
-  if (start_index > end_index)
-    return 0;
-
-  int num_unpacked = end_index - start_index + 1;
-  if (num_unpacked <= 0 || !lua_checkstack(L, num_unpacked))
-    return luaL_error(L, "Too many results to unpack!");
-
-  lua_rawgeti(L, 1, start_index);
-  while (start_index++ < end_index)
-    lua_rawgeti(L, 1, start_index);
-
-  return num_unpacked;
-}
+static const char luavbase_prelude[] =
+  "local native, unwind, slow_tostring, slow_tonumber = ...\n"
+  "local error, getmetatable = native.error, native.getmetatable\n"
+  "local rawget, setmetatable = native.rawget, native.setmetatable\n"
+  "local native_ipairs, native_next = native.ipairs, native.next\n"
+  "local native_pcall, native_tonumber = native.pcall, native.tonumber\n"
+  "local native_type = native.type\n"
+  "local format, sub = native.string.format, native.string.sub\n"
+  "\n"
+  "local function expected(name, value)\n"
+  "  local message = \"bad argument #1 to '%s' \" ..\n"
+  "    \"(table or string expected, got %s)\"\n"
+  "  error(format(message, name, native_type(value)), 3)\n"
+  "end\n"
+  "\n"
+  "-- The name and parent of every class made by `class()`, and the newest\n"
+  "-- class with each name.\n"
+  "local weak = { __mode = \"k\" }\n"
+  "local class_names = setmetatable({}, weak)\n"
+  "local class_parents = setmetatable({}, weak)\n"
+  "local classes = setmetatable({}, { __mode = \"v\" })\n"
+  "\n"
+  "local function string_next(str, i)\n"
+  "  i = (i or 0) + 1\n"
+  "  if i <= #str then\n"
+  "    return i, sub(str, i, i)\n"
+  "  end\n"
+  "end\n"
+  "\n"
+  "function ipairs(value)\n"
+  "  local t = native_type(value)\n"
+  "  if t == \"table\" then\n"
+  "    return native_ipairs(value)\n"
+  "  elseif t == \"string\" then\n"
+  "    return string_next, value, 0\n"
+  "  end\n"
+  "  expected(\"ipairs\", value)\n"
+  "end\n"
+  "\n"
+  "function next(value, key)\n"
+  "  local t = native_type(value)\n"
+  "  if t == \"table\" then\n"
+  "    return native_next(value, key)\n"
+  "  elseif t == \"string\" then\n"
+  "    return string_next(value, key)\n"
+  "  end\n"
+  "  expected(\"next\", value)\n"
+  "end\n"
+  "\n"
+  "function pairs(value)\n"
+  "  local t = native_type(value)\n"
+  "  if t == \"table\" then\n"
+  "    return native_next, value, nil\n"
+  "  elseif t == \"string\" then\n"
+  "    return string_next, value, nil\n"
+  "  end\n"
+  "  expected(\"pairs\", value)\n"
+  "end\n"
+  "\n"
+  "local function rethrow(ok, ...)\n"
+  "  if not ok and ... == unwind then\n"
+  "    error(unwind, 0)\n"
+  "  end\n"
+  "  return ok, ...\n"
+  "end\n"
+  "\n"
+  "function pcall(func, ...)\n"
+  "  return rethrow(native_pcall(func, ...))\n"
+  "end\n"
+  "\n"
+  "function tonumber(value)\n"
+  "  local t = native_type(value)\n"
+  "  if t == \"number\" then\n"
+  "    return value\n"
+  "  elseif t == \"string\" then\n"
+  "    return native_tonumber(value) or 0\n"
+  "  elseif t == \"boolean\" then\n"
+  "    return value and 1 or 0\n"
+  "  end\n"
+  "  return slow_tonumber(value)\n"
+  "end\n"
+  "\n"
+  "function tostring(value)\n"
+  "  local t = native_type(value)\n"
+  "  if t == \"string\" then\n"
+  "    return value\n"
+  "  elseif t == \"number\" or t == \"boolean\" or t == \"nil\" or\n"
+  "    t == \"cdata\" then\n"
+  "    return native.tostring(value)\n"
+  "  end\n"
+  "  return slow_tostring(value)\n"
+  "end\n"
+  "\n"
+  "local function instantiate(class, ...)\n"
+  "  local object = setmetatable({}, class)\n"
+  "  local init = class.init\n"
+  "  if init then\n"
+  "    init(object, ...)\n"
+  "  end\n"
+  "  return object\n"
+  "end\n"
+  "\n"
+  "function class(name, parent)\n"
+  "  if native_type(name) ~= \"string\" then\n"
+  "    error(format(\"bad argument #1 to 'class' (string expected, got %s)\",\n"
+  "      native_type(name)), 2)\n"
+  "  elseif parent ~= nil and class_names[parent] == nil then\n"
+  "    error(\"bad argument #2 to 'class' (class expected)\", 2)\n"
+  "  end\n"
+  "\n"
+  "  local class = {}\n"
+  "  class.__index = class\n"
+  "  class_names[class] = name\n"
+  "  class_parents[class] = parent\n"
+  "  classes[name] = class\n"
+  "  return setmetatable(class, { __index = parent, __call = instantiate })\n"
+  "end\n"
+  "\n"
+  "local function type_of(value, t)\n"
+  "  local custom = rawget(value, \"__type\")\n"
+  "  if custom == nil then\n"
+  "    return class_names[getmetatable(value)] or t\n"
+  "  elseif native_type(custom) ~= \"string\" then\n"
+  "    error(\"Invalid table type!\", 3)\n"
+  "  end\n"
+  "  return custom\n"
+  "end\n"
+  "\n"
+  "function check(value, expect)\n"
+  "  local t = native_type(value)\n"
+  "  if t == expect then\n"
+  "    return value\n"
+  "  elseif t == \"table\" then\n"
+  "    local class = getmetatable(value)\n"
+  "    if rawget(value, \"__type\") ~= nil then\n"
+  "      t = type_of(value, t)\n"
+  "      if t == expect then\n"
+  "        return value\n"
+  "      end\n"
+  "    elseif class_names[class] ~= nil then\n"
+  "      t = class_names[class]\n"
+  "      repeat\n"
+  "        if class_names[class] == expect then\n"
+  "          return value\n"
+  "        end\n"
+  "        class = class_parents[class]\n"
+  "      until class == nil\n"
+  "    end\n"
+  "  end\n"
+  "\n"
+  "  if native_type(expect) ~= \"string\" then\n"
+  "    error(format(\"bad argument #2 to 'check' (string expected, got %s)\",\n"
+  "      native_type(expect)), 2)\n"
+  "  end\n"
+  "  error(format(\"Expected %s, but got %s!\", expect, t), 2)\n"
+  "end\n"
+  "\n"
+  "function type(value)\n"
+  "  local t = native_type(value)\n"
+  "  if t == \"table\" then\n"
+  "    t = type_of(value, t)\n"
+  "  end\n"
+  "  return t\n"
+  "end\n"
+  "\n"
+  "unpack = native.unpack\n"
+  "\n"
+  "return class_names, classes\n";
 
 void luaopen_vbase(lua_State* L) {
   // clang-format off
   static const luaL_Reg luavbase_lib[] = {
     {"assert", luavbase_assert},
-    {"check", luavbase_check},
-    {"ipairs", luavbase_ipairs},
-    {"next", luavbase_next},
-    {"pairs", luavbase_pairs},
-    {"pcall", luavbase_pcall},
     {"sleep", luavbase_sleep},
     {"rawcheck", luavbase_rawcheck},
     {"rawtype", luavbase_rawtype},
-    {"tonumber", luavbase_tonumber},
-    {"tostring", luavbase_tostring},
-    {"type", luavbase_type},
-    {"unpack", luavbase_unpack}
+    {NULL, NULL}
   };
   // clang-format on
 
@@ -554,5 +577,13 @@ void luaopen_vbase(lua_State* L) {
        reg->name != NULL && reg->func != NULL; reg++) {
     lua_register(L, reg->name, reg->func);
   }
-}
 
+  luasystem_push_unwind(L);
+  lua_pushcfunction(L, luavbase_tostring);
+  lua_pushcfunction(L, luavbase_tonumber);
+  luanative_run(L, "=[vbase]", luavbase_prelude, 3, 2);
+
+  // Saves look classes up by name to restore instances.
+  lua_setfield(L, LUA_REGISTRYINDEX, LUAVBASE_CLASSES);
+  lua_setfield(L, LUA_REGISTRYINDEX, LUAVBASE_CLASS_NAMES);
+}
@@ -17,14 +17,29 @@
 #include <lua.h>
 #include <lualib.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
+// How many levels of nested tables `tostring()` writes before writing `{...}`
+// instead.
+#define LUAVBASE_TOSTRING_MAX_DEPTH 32
+
+// How many bytes `tostring()` writes for a table before cutting it short.
+#define LUAVBASE_TOSTRING_MAX_SIZE (1024 * 1024)
+
+// The registry fields holding the name of every class made by `class()`, keyed
+// by class, and the newest class with each name, keyed by name.
+#define LUAVBASE_CLASS_NAMES "vgame.class_names"
+#define LUAVBASE_CLASSES "vgame.classes"
+
 /**
   Attempts to convert the given Lua value to a string.
 
   If the given value is a table, it will first attempt to return the result of
   the table  method `__tostring`. If the `__tostring field doesn't exist, it
-  will return a string representation of the given table.
+  will return a string representation of the given table, which is limited to
+  `LUAVBASE_TOSTRING_MAX_DEPTH` levels of nested tables and
+  `LUAVBASE_TOSTRING_MAX_SIZE` bytes.
 
   If the given value is a function, the given function will be called with no
   arguments and the return value will be returned as a string.
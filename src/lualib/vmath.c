@@ -7,6 +7,7 @@
 */
 
 #include "vmath.h"
+#include "native.h"
 
 /*
   Returns the absolute value of the given Lua number.
@@ -98,7 +99,7 @@ static int luavmath_frexp(lua_State* L) {
   int e;
   lua_pushnumber(L, frexpf(luaL_checknumber(L, 1), &e));
   lua_pushinteger(L, e);
-  return 1;
+  return 2;
 }
 
 /*
@@ -204,6 +205,62 @@ static int luavmath_tanh(lua_State* L) {
   return 1;
 }
 
+/**
+  Points the math library at Lua's own math functions, which are double
+  precision and which LuaJIT compiles into machine instructions rather than
+  calls, and adds the helpers games keep writing themselves. The C functions
+  stay available in `math.f32`.
+*/
+static const char luavmath_prelude[] =
+  "local native = ...\n"
+  "local fast = native.math\n"
+  "local ceil, floor = fast.ceil, fast.floor\n"
+  "\n"
+  "math.abs, math.acos, math.asin = fast.abs, fast.acos, fast.asin\n"
+  "math.atan, math.atan2, math.ceil = fast.atan, fast.atan2, fast.ceil\n"
+  "math.cos, math.cosh, math.exp = fast.cos, fast.cosh, fast.exp\n"
+  "math.floor, math.fmod, math.frexp = fast.floor, fast.fmod, fast.frexp\n"
+  "math.ldexp, math.log, math.log10 = fast.ldexp, fast.log, fast.log10\n"
+  "math.max, math.min, math.pow = fast.max, fast.min, fast.pow\n"
+  "math.sin, math.sinh, math.sqrt = fast.sin, fast.sinh, fast.sqrt\n"
+  "math.tan, math.tanh = fast.tan, fast.tanh\n"
+  "\n"
+  "function math.clamp(value, min, max)\n"
+  "  if value < min then\n"
+  "    return min\n"
+  "  elseif value > max then\n"
+  "    return max\n"
+  "  end\n"
+  "  return value\n"
+  "end\n"
+  "\n"
+  "function math.int(value)\n"
+  "  if value < 0 then\n"
+  "    return ceil(value)\n"
+  "  end\n"
+  "  return floor(value)\n"
+  "end\n"
+  "\n"
+  "function math.lerp(a, b, t)\n"
+  "  return a + (b - a) * t\n"
+  "end\n"
+  "\n"
+  "function math.round(value)\n"
+  "  if value < 0 then\n"
+  "    return ceil(value - 0.5)\n"
+  "  end\n"
+  "  return floor(value + 0.5)\n"
+  "end\n"
+  "\n"
+  "function math.sign(value)\n"
+  "  if value > 0 then\n"
+  "    return 1\n"
+  "  elseif value < 0 then\n"
+  "    return -1\n"
+  "  end\n"
+  "  return 0\n"
+  "end\n";
+
 void luaopen_vmath(lua_State* L) {
   // Probably the largest library in the entire runtime.
   static const luaL_Reg luavmath_lib[] = {
@@ -238,5 +295,12 @@ void luaopen_vmath(lua_State* L) {
 
   lua_pushnumber(L, HUGE_VALF);
   lua_setfield(L, -2, "HUGE");
+
+  lua_newtable(L);
+  luaL_register(L, NULL, luavmath_lib);
+  lua_setfield(L, -2, "f32");
+  lua_pop(L, 1);
+
+  luanative_run(L, "=[vmath]", luavmath_prelude, 0, 0);
 }
 
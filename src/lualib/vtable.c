@@ -0,0 +1,195 @@
+/**
+  src/lualib/vtable.c
+
+  Written by DoelJavid for V-GAME.
+
+  https://github.com/DoelJavid/v-game
+*/
+
+#include "vtable.h"
+#include "native.h"
+
+/**
+  Creates a table with space preallocated for the given amount of array and
+  hash entries. Only used when Lua doesn't provide its own `table.new()`.
+*/
+static int luavtable_new(lua_State* L) {
+  lua_createtable(L, luaL_optint(L, 1, 0), luaL_optint(L, 2, 0));
+  return 1;
+}
+
+/**
+  Defines the `table` library on top of Lua's own table functions, which
+  LuaJIT can compile into traces. `table.sort()` is an introsort written in
+  Lua rather than Lua's C quicksort, so the comparator can be inlined into the
+  trace instead of being called through the C API for every comparison.
+
+  Receives the native libraries and the fallback for `table.new()`.
+*/
+static const char luavtable_source[] =
+  "local native, create = ...\n"
+  "local fast = native.table\n"
+  "local error, format = native.error, native.string.format\n"
+  "local floor, log = native.math.floor, native.math.log\n"
+  "local gsub, loadstring = native.string.gsub, native.loadstring\n"
+  "local native_type = native.type\n"
+  "\n"
+  "table = {\n"
+  "  concat = fast.concat,\n"
+  "  insert = fast.insert,\n"
+  "  new = fast.new or create,\n"
+  "  remove = fast.remove\n"
+  "}\n"
+  "\n"
+  "table.clear = fast.clear or function(t)\n"
+  "  for key in native.next, t do\n"
+  "    t[key] = nil\n"
+  "  end\n"
+  "end\n"
+  "\n"
+  "function table.swapremove(t, index)\n"
+  "  local last = #t\n"
+  "  if index == nil then\n"
+  "    if last == 0 then\n"
+  "      return nil\n"
+  "    end\n"
+  "    index = last\n"
+  "  elseif index < 1 or index > last or floor(index) ~= index then\n"
+  "    error(\"bad argument #2 to 'swapremove' (position out of bounds)\", 2)\n"
+  "  end\n"
+  "  local value = t[index]\n"
+  "  t[index] = t[last]\n"
+  "  t[last] = nil\n"
+  "  return value\n"
+  "end\n"
+  "\n"
+  "-- Compiled twice, once comparing with `<` directly and once calling the\n"
+  "-- comparator, so sorting without one never makes a call.\n"
+  "local template = [[\n"
+  "local floor, invalid = ...\n"
+  "\n"
+  "local function insertion(t, lo, hi, less)\n"
+  "  for i = lo + 1, hi do\n"
+  "    local value = t[i]\n"
+  "    local j = i - 1\n"
+  "    while j >= lo and LESS(value, t[j]) do\n"
+  "      t[j + 1] = t[j]\n"
+  "      j = j - 1\n"
+  "    end\n"
+  "    t[j + 1] = value\n"
+  "  end\n"
+  "end\n"
+  "\n"
+  "local function sift(t, lo, root, size, less)\n"
+  "  local value = t[lo + root]\n"
+  "  while true do\n"
+  "    local child = root * 2 + 1\n"
+  "    if child >= size then\n"
+  "      break\n"
+  "    end\n"
+  "    local right = child + 1\n"
+  "    if right < size and LESS(t[lo + child], t[lo + right]) then\n"
+  "      child = right\n"
+  "    end\n"
+  "    if not LESS(value, t[lo + child]) then\n"
+  "      break\n"
+  "    end\n"
+  "    t[lo + root] = t[lo + child]\n"
+  "    root = child\n"
+  "  end\n"
+  "  t[lo + root] = value\n"
+  "end\n"
+  "\n"
+  "local function heapsort(t, lo, hi, less)\n"
+  "  local size = hi - lo + 1\n"
+  "  for root = floor(size / 2) - 1, 0, -1 do\n"
+  "    sift(t, lo, root, size, less)\n"
+  "  end\n"
+  "  for last = size - 1, 1, -1 do\n"
+  "    t[lo], t[lo + last] = t[lo + last], t[lo]\n"
+  "    sift(t, lo, 0, last, less)\n"
+  "  end\n"
+  "end\n"
+  "\n"
+  "local function introsort(t, lo, hi, depth, less)\n"
+  "  while hi - lo > 16 do\n"
+  "    if depth == 0 then\n"
+  "      return heapsort(t, lo, hi, less)\n"
+  "    end\n"
+  "    depth = depth - 1\n"
+  "\n"
+  "    local mid = floor((lo + hi) / 2)\n"
+  "    if LESS(t[mid], t[lo]) then\n"
+  "      t[mid], t[lo] = t[lo], t[mid]\n"
+  "    end\n"
+  "    if LESS(t[hi], t[mid]) then\n"
+  "      t[hi], t[mid] = t[mid], t[hi]\n"
+  "      if LESS(t[mid], t[lo]) then\n"
+  "        t[mid], t[lo] = t[lo], t[mid]\n"
+  "      end\n"
+  "    end\n"
+  "\n"
+  "    local pivot, i, j = t[mid], lo, hi\n"
+  "    while i <= j do\n"
+  "      while LESS(t[i], pivot) do\n"
+  "        i = i + 1\n"
+  "        if i > hi then invalid() end\n"
+  "      end\n"
+  "      while LESS(pivot, t[j]) do\n"
+  "        j = j - 1\n"
+  "        if j < lo then invalid() end\n"
+  "      end\n"
+  "      if i <= j then\n"
+  "        t[i], t[j] = t[j], t[i]\n"
+  "        i, j = i + 1, j - 1\n"
+  "      end\n"
+  "    end\n"
+  "\n"
+  "    if j - lo < hi - i then\n"
+  "      introsort(t, lo, j, depth, less)\n"
+  "      lo = i\n"
+  "    else\n"
+  "      introsort(t, i, hi, depth, less)\n"
+  "      hi = j\n"
+  "    end\n"
+  "  end\n"
+  "  insertion(t, lo, hi, less)\n"
+  "end\n"
+  "\n"
+  "return introsort\n"
+  "]]\n"
+  "\n"
+  "local function invalid()\n"
+  "  error(\"invalid order function for sorting\", 0)\n"
+  "end\n"
+  "\n"
+  "local function compile(less)\n"
+  "  local source = gsub(template, \"LESS%((.-), (.-)%)\", less)\n"
+  "  return loadstring(source, \"=[vtable]\")(floor, invalid)\n"
+  "end\n"
+  "\n"
+  "local sort_default = compile(\"(%1 < %2)\")\n"
+  "local sort_with = compile(\"less(%1, %2)\")\n"
+  "\n"
+  "function table.sort(t, less)\n"
+  "  local size = #t\n"
+  "  if size < 2 then\n"
+  "    return\n"
+  "  end\n"
+  "\n"
+  "  local depth = 2 * floor(log(size) / log(2))\n"
+  "  if less == nil then\n"
+  "    sort_default(t, 1, size, depth)\n"
+  "  elseif native_type(less) == \"function\" then\n"
+  "    sort_with(t, 1, size, depth, less)\n"
+  "  else\n"
+  "    local message = \"bad argument #2 to 'sort' \" ..\n"
+  "      \"(function expected, got %s)\"\n"
+  "    error(format(message, native_type(less)), 2)\n"
+  "  end\n"
+  "end\n";
+
+void luaopen_vtable(lua_State* L) {
+  lua_pushcfunction(L, luavtable_new);
+  luanative_run(L, "=[vtable]", luavtable_source, 1, 0);
+}
@@ -0,0 +1,20 @@
+/**
+  src/lualib/vtable.h
+
+  Written by DoelJavid for V-GAME.
+
+  https://github.com/DoelJavid/v-game
+*/
+
+#ifndef LUALIB_VTABLE_H
+#define LUALIB_VTABLE_H
+
+#include <lua.h>
+#include <lauxlib.h>
+
+/*
+  Opens the V-GAME table library for the given lua state.
+*/
+void luaopen_vtable(lua_State* L);
+
+#endif
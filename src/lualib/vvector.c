@@ -0,0 +1,294 @@
+/**
+  src/lualib/vvector.c
+
+  Written by DoelJavid for V-GAME.
+
+  https://github.com/DoelJavid/v-game
+*/
+
+#include "vvector.h"
+#include "native.h"
+
+/**
+  Defines `vec2` and `mat3`. Operators always return new values, while methods
+  like `add()` and `rotate()` change the value they're called on and return it
+  for chaining, so hot loops can avoid allocating at all. Matrices are 2-D
+  affine transforms whose last row is always `0, 0, 1`, so only the first two
+  rows are stored.
+*/
+static const char luavvector_source[] =
+  "local native = ...\n"
+  "local ffi = native.ffi\n"
+  "local cos, sin, sqrt = native.math.cos, native.math.sin, native.math.sqrt\n"
+  "local format, type = native.string.format, native.type\n"
+  "local setmetatable = native.setmetatable\n"
+  "\n"
+  "local vec2_methods, mat3_methods = {}, {}\n"
+  "local vec2_meta = { __index = vec2_methods }\n"
+  "local mat3_meta = { __index = mat3_methods }\n"
+  "local new_vec2, new_mat3, is_vec2, is_mat3\n"
+  "\n"
+  "--[[ vec2 ]]--\n"
+  "\n"
+  "function vec2_meta.__add(a, b)\n"
+  "  return new_vec2(a.x + b.x, a.y + b.y)\n"
+  "end\n"
+  "\n"
+  "function vec2_meta.__sub(a, b)\n"
+  "  return new_vec2(a.x - b.x, a.y - b.y)\n"
+  "end\n"
+  "\n"
+  "function vec2_meta.__mul(a, b)\n"
+  "  if type(a) == \"number\" then\n"
+  "    return new_vec2(a * b.x, a * b.y)\n"
+  "  elseif type(b) == \"number\" then\n"
+  "    return new_vec2(a.x * b, a.y * b)\n"
+  "  end\n"
+  "  return new_vec2(a.x * b.x, a.y * b.y)\n"
+  "end\n"
+  "\n"
+  "function vec2_meta.__div(a, b)\n"
+  "  if type(b) == \"number\" then\n"
+  "    return new_vec2(a.x / b, a.y / b)\n"
+  "  end\n"
+  "  return new_vec2(a.x / b.x, a.y / b.y)\n"
+  "end\n"
+  "\n"
+  "function vec2_meta.__unm(a)\n"
+  "  return new_vec2(-a.x, -a.y)\n"
+  "end\n"
+  "\n"
+  "function vec2_meta.__eq(a, b)\n"
+  "  return is_vec2(a) and is_vec2(b) and a.x == b.x and a.y == b.y\n"
+  "end\n"
+  "\n"
+  "function vec2_meta.__tostring(a)\n"
+  "  return format(\"vec2(%.14g, %.14g)\", a.x, a.y)\n"
+  "end\n"
+  "\n"
+  "function vec2_methods.add(self, other)\n"
+  "  self.x, self.y = self.x + other.x, self.y + other.y\n"
+  "  return self\n"
+  "end\n"
+  "\n"
+  "function vec2_methods.copy(self)\n"
+  "  return new_vec2(self.x, self.y)\n"
+  "end\n"
+  "\n"
+  "function vec2_methods.cross(self, other)\n"
+  "  return self.x * other.y - self.y * other.x\n"
+  "end\n"
+  "\n"
+  "function vec2_methods.distance(self, other)\n"
+  "  local dx, dy = other.x - self.x, other.y - self.y\n"
+  "  return sqrt(dx * dx + dy * dy)\n"
+  "end\n"
+  "\n"
+  "function vec2_methods.dot(self, other)\n"
+  "  return self.x * other.x + self.y * other.y\n"
+  "end\n"
+  "\n"
+  "function vec2_methods.length(self)\n"
+  "  return sqrt(self.x * self.x + self.y * self.y)\n"
+  "end\n"
+  "\n"
+  "function vec2_methods.lerp(self, other, t)\n"
+  "  self.x = self.x + (other.x - self.x) * t\n"
+  "  self.y = self.y + (other.y - self.y) * t\n"
+  "  return self\n"
+  "end\n"
+  "\n"
+  "function vec2_methods.normalize(self)\n"
+  "  local length = sqrt(self.x * self.x + self.y * self.y)\n"
+  "  if length > 0 then\n"
+  "    self.x, self.y = self.x / length, self.y / length\n"
+  "  end\n"
+  "  return self\n"
+  "end\n"
+  "\n"
+  "function vec2_methods.rotate(self, radians)\n"
+  "  local c, s = cos(radians), sin(radians)\n"
+  "  self.x, self.y = self.x * c - self.y * s, self.x * s + self.y * c\n"
+  "  return self\n"
+  "end\n"
+  "\n"
+  "function vec2_methods.scale(self, x, y)\n"
+  "  self.x, self.y = self.x * x, self.y * (y or x)\n"
+  "  return self\n"
+  "end\n"
+  "\n"
+  "function vec2_methods.set(self, x, y)\n"
+  "  self.x, self.y = x, y\n"
+  "  return self\n"
+  "end\n"
+  "\n"
+  "function vec2_methods.sub(self, other)\n"
+  "  self.x, self.y = self.x - other.x, self.y - other.y\n"
+  "  return self\n"
+  "end\n"
+  "\n"
+  "--[[ mat3 ]]--\n"
+  "\n"
+  "local function transform(m, x, y)\n"
+  "  return m.m11 * x + m.m12 * y + m.m13, m.m21 * x + m.m22 * y + m.m23\n"
+  "end\n"
+  "\n"
+  "local function multiply(out, a, b)\n"
+  "  local m11 = a.m11 * b.m11 + a.m12 * b.m21\n"
+  "  local m12 = a.m11 * b.m12 + a.m12 * b.m22\n"
+  "  local m13 = a.m11 * b.m13 + a.m12 * b.m23 + a.m13\n"
+  "  local m21 = a.m21 * b.m11 + a.m22 * b.m21\n"
+  "  local m22 = a.m21 * b.m12 + a.m22 * b.m22\n"
+  "  local m23 = a.m21 * b.m13 + a.m22 * b.m23 + a.m23\n"
+  "  out.m11, out.m12, out.m13 = m11, m12, m13\n"
+  "  out.m21, out.m22, out.m23 = m21, m22, m23\n"
+  "  return out\n"
+  "end\n"
+  "\n"
+  "local function post(self, m11, m12, m13, m21, m22, m23)\n"
+  "  local a11, a12, a21, a22 = self.m11, self.m12, self.m21, self.m22\n"
+  "  self.m13 = a11 * m13 + a12 * m23 + self.m13\n"
+  "  self.m23 = a21 * m13 + a22 * m23 + self.m23\n"
+  "  self.m11, self.m12 = a11 * m11 + a12 * m21, a11 * m12 + a12 * m22\n"
+  "  self.m21, self.m22 = a21 * m11 + a22 * m21, a21 * m12 + a22 * m22\n"
+  "  return self\n"
+  "end\n"
+  "\n"
+  "function mat3_meta.__mul(a, b)\n"
+  "  if is_vec2(b) then\n"
+  "    return new_vec2(transform(a, b.x, b.y))\n"
+  "  end\n"
+  "  return multiply(new_mat3(), a, b)\n"
+  "end\n"
+  "\n"
+  "function mat3_meta.__tostring(m)\n"
+  "  return format(\"mat3(%.14g, %.14g, %.14g, %.14g, %.14g, %.14g)\",\n"
+  "    m.m11, m.m12, m.m13, m.m21, m.m22, m.m23)\n"
+  "end\n"
+  "\n"
+  "function mat3_methods.apply(self, point)\n"
+  "  point.x, point.y = transform(self, point.x, point.y)\n"
+  "  return point\n"
+  "end\n"
+  "\n"
+  "function mat3_methods.applyAll(self, points)\n"
+  "  for i = 1, #points do\n"
+  "    local point = points[i]\n"
+  "    point.x, point.y = transform(self, point.x, point.y)\n"
+  "  end\n"
+  "  return points\n"
+  "end\n"
+  "\n"
+  "function mat3_methods.copy(self)\n"
+  "  return new_mat3(\n"
+  "    self.m11, self.m12, self.m13, self.m21, self.m22, self.m23\n"
+  "  )\n"
+  "end\n"
+  "\n"
+  "function mat3_methods.identity(self)\n"
+  "  self.m11, self.m12, self.m13 = 1, 0, 0\n"
+  "  self.m21, self.m22, self.m23 = 0, 1, 0\n"
+  "  return self\n"
+  "end\n"
+  "\n"
+  "function mat3_methods.invert(self)\n"
+  "  local a, b, c = self.m11, self.m12, self.m13\n"
+  "  local d, e, f = self.m21, self.m22, self.m23\n"
+  "  local det = a * e - b * d\n"
+  "  self.m11, self.m12 = e / det, -b / det\n"
+  "  self.m21, self.m22 = -d / det, a / det\n"
+  "  self.m13 = -(self.m11 * c + self.m12 * f)\n"
+  "  self.m23 = -(self.m21 * c + self.m22 * f)\n"
+  "  return self\n"
+  "end\n"
+  "\n"
+  "function mat3_methods.multiply(self, other)\n"
+  "  return multiply(self, self, other)\n"
+  "end\n"
+  "\n"
+  "function mat3_methods.rotate(self, radians)\n"
+  "  local c, s = cos(radians), sin(radians)\n"
+  "  return post(self, c, -s, 0, s, c, 0)\n"
+  "end\n"
+  "\n"
+  "function mat3_methods.scale(self, x, y)\n"
+  "  return post(self, x, 0, 0, 0, y or x, 0)\n"
+  "end\n"
+  "\n"
+  "function mat3_methods.transformAll(self, points, out)\n"
+  "  out = out or {}\n"
+  "  for i = 1, #points do\n"
+  "    local point, target = points[i], out[i]\n"
+  "    if target then\n"
+  "      target.x, target.y = transform(self, point.x, point.y)\n"
+  "    else\n"
+  "      out[i] = new_vec2(transform(self, point.x, point.y))\n"
+  "    end\n"
+  "  end\n"
+  "  return out\n"
+  "end\n"
+  "\n"
+  "function mat3_methods.translate(self, x, y)\n"
+  "  return post(self, 1, 0, x, 0, 1, y)\n"
+  "end\n"
+  "\n"
+  "-- The FFI requires metatables to be complete before they're attached.\n"
+  "if ffi then\n"
+  "  ffi.cdef([[\n"
+  "    typedef struct { double x, y; } vgame_vec2;\n"
+  "    typedef struct { double m11, m12, m13, m21, m22, m23; } vgame_mat3;\n"
+  "  ]])\n"
+  "  new_vec2 = ffi.metatype(\"vgame_vec2\", vec2_meta)\n"
+  "  new_mat3 = ffi.metatype(\"vgame_mat3\", mat3_meta)\n"
+  "\n"
+  "  local istype = ffi.istype\n"
+  "  is_vec2 = function(value) return istype(new_vec2, value) end\n"
+  "  is_mat3 = function(value) return istype(new_mat3, value) end\n"
+  "else\n"
+  "  local getmetatable = native.getmetatable\n"
+  "  new_vec2 = function(x, y)\n"
+  "    return setmetatable({ x = x or 0, y = y or 0 }, vec2_meta)\n"
+  "  end\n"
+  "  new_mat3 = function(m11, m12, m13, m21, m22, m23)\n"
+  "    return setmetatable({\n"
+  "      m11 = m11 or 0, m12 = m12 or 0, m13 = m13 or 0,\n"
+  "      m21 = m21 or 0, m22 = m22 or 0, m23 = m23 or 0\n"
+  "    }, mat3_meta)\n"
+  "  end\n"
+  "  is_vec2 = function(value) return getmetatable(value) == vec2_meta end\n"
+  "  is_mat3 = function(value) return getmetatable(value) == mat3_meta end\n"
+  "end\n"
+  "\n"
+  "vec2 = setmetatable({ is = is_vec2 }, {\n"
+  "  __call = function(_, x, y) return new_vec2(x or 0, y or 0) end\n"
+  "})\n"
+  "\n"
+  "mat3 = setmetatable({\n"
+  "  is = is_mat3,\n"
+  "  rotation = function(radians)\n"
+  "    local c, s = cos(radians), sin(radians)\n"
+  "    return new_mat3(c, -s, 0, s, c, 0)\n"
+  "  end,\n"
+  "  scaling = function(x, y)\n"
+  "    return new_mat3(x, 0, 0, 0, y or x, 0)\n"
+  "  end,\n"
+  "  translation = function(x, y)\n"
+  "    return new_mat3(1, 0, x, 0, 1, y)\n"
+  "  end\n"
+  "}, {\n"
+  "  __call = function(_, m11, m12, m13, m21, m22, m23)\n"
+  "    if m11 == nil then\n"
+  "      return new_mat3(1, 0, 0, 0, 1, 0)\n"
+  "    end\n"
+  "    return new_mat3(m11, m12 or 0, m13 or 0, m21 or 0, m22 or 0, m23 or 0)\n"
+  "  end\n"
+  "})\n"
+  "\n"
+  "return {\n"
+  "  is_vec2 = is_vec2, is_mat3 = is_mat3, vec2 = new_vec2, mat3 = new_mat3\n"
+  "}\n";
+
+void luaopen_vvector(lua_State* L) {
+  luanative_run(L, "=[vvector]", luavvector_source, 0, 1);
+  lua_setfield(L, LUA_REGISTRYINDEX, LUAVVECTOR_REGISTRY);
+}
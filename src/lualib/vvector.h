@@ -0,0 +1,26 @@
+/**
+  src/lualib/vvector.h
+
+  Written by DoelJavid for V-GAME.
+
+  https://github.com/DoelJavid/v-game
+*/
+
+#ifndef LUALIB_VVECTOR_H
+#define LUALIB_VVECTOR_H
+
+#include <lua.h>
+#include <lauxlib.h>
+
+// The registry field holding the functions saves use to recognize and rebuild
+// vectors: `is_vec2`, `is_mat3`, `vec2` and `mat3`.
+#define LUAVVECTOR_REGISTRY "vgame.vvector"
+
+/*
+  Opens the `vec2` and `mat3` types for the given lua state. On LuaJIT they're
+  FFI structs, which the JIT compiler can keep in registers instead of
+  allocating, and on other Lua implementations they fall back to tables.
+*/
+void luaopen_vvector(lua_State* L);
+
+#endif
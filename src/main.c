@@ -9,14 +9,30 @@
 #include "api/intro.h"
 #include "api/init.h"
 #include "lualib/init.h"
+#include "lualib/runner.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
 typedef struct {
-  char game_path[260];
+  char* game_path;
   bool fullscreen;
   bool cut_intro;
+  const char* record_input;
+  const char* replay_input;
+  bool latency_probe;
+  bool headless;
+  size_t bench_frames;
+  const char* profile_path;
+  const char* trace_path;
+  logger_level_t log_level;
+  const char* pack_path;
+  size_t memory_cap;
+  double gc_budget;
+  bool jit_report;
+  size_t max_ticks;
+  size_t instances;
+  size_t jobs;
 }  runtime_args_t;
 
 /**
@@ -43,6 +59,36 @@ void display_help(void) {
 "## FLAGS:\n"
 "-f, --fullscreen: Runs the runtime in fullscreen.\n"
 "-c, --cut-intro: Skips the intro screen.\n"
+"--record-input <file>: Records the input of every controller to a file.\n"
+"--replay-input <file>: Plays back recorded input instead of reading\n"
+"  controllers, then exits. Use the same flags the recording was made with.\n"
+"--latency-probe: Measures how long button presses take to reach the screen\n"
+"  and prints the distribution on exit.\n"
+"--headless: Runs without a window, audio device or frame limit. Pair with\n"
+"  --replay-input to drive the game.\n"
+"--bench <frames>: Runs the given number of frames uncapped with the intro\n"
+"  skipped, then prints frame times per phase as a table and as JSON.\n"
+"--profile <file>: Samples the Lua stack while the game runs and writes it\n"
+"  to a file as collapsed stacks for flamegraph tools.\n"
+"--trace <file>: Records a timeline of every frame and writes it to a file as\n"
+"  Chrome trace-event JSON on exit or when F9 is pressed.\n"
+"--log-level <level>: Only logs messages at or above the given level, which\n"
+"  is one of info, warning or error. Defaults to info.\n"
+"--pack <file>: Packs the game and every file next to it into a cartridge\n"
+"  instead of running it. Cartridges can be run like any other game.\n"
+"--memory-cap <kilobytes>: Limits how much memory the game can allocate. Going\n"
+"  over the limit throws an out of memory error.\n"
+"--gc-budget <ms>: How long garbage collection can run each frame while\n"
+"  waiting for the next present. Defaults to 1. Use 0 to let Lua collect\n"
+"  garbage whenever it allocates instead.\n"
+"--jit-report: Logs how many traces LuaJIT compiled and the places that\n"
+"  aborted the most traces on exit.\n"
+"--ticks <n>: Stops the game after the given number of ticks.\n"
+"--instances <n>: Runs the given number of headless copies of the game at\n"
+"  once, each with its own saves, and exits with 1 if any of them failed.\n"
+"  Pair with --ticks or --replay-input so they stop.\n"
+"--jobs <n>: How many instances run at the same time. Defaults to one per\n"
+"  CPU.\n"
 "-h, --help: Displays this message.\n"
   );
   // clang-format on
@@ -50,6 +96,51 @@ void display_help(void) {
   exit(0);
 }
 
+/**
+  Returns the value following the flag at `*index` and moves the index past it.
+  Exits the application if the flag has no value.
+*/
+const char* get_flag_value(int argc, char** argv, int* index) {
+  if (*index + 1 >= argc) {
+    SYSTEM_PANIC_LOG("Flag \"%s\" expects a value!", argv[*index]);
+    exit(-1);
+  }
+
+  return argv[++*index];
+}
+
+/**
+  Returns true if the given string ends with the given suffix.
+*/
+bool ends_with(const char* str, const char* suffix) {
+  size_t length = strlen(str), suffix_length = strlen(suffix);
+  return length >= suffix_length &&
+         strcmp(&str[length - suffix_length], suffix) == 0;
+}
+
+/**
+  Returns a newly allocated copy of the given game path with `init.lua` added
+  to directories and `.lua` added to paths without an extension. Exits the
+  application if out of memory.
+*/
+char* resolve_game_path(const char* path) {
+  const char* suffix = "";
+  if (ends_with(path, "/") || ends_with(path, "\\"))
+    suffix = "init.lua";
+  else if (!ends_with(path, ".lua") && !ends_with(path, CART_EXTENSION))
+    suffix = ".lua";
+
+  char* game_path = malloc(strlen(path) + strlen(suffix) + 1);
+  if (!game_path) {
+    SYSTEM_PANIC_LOG("Out of memory!");
+    exit(-1);
+  }
+
+  strcpy(game_path, path);
+  strcat(game_path, suffix);
+  return game_path;
+}
+
 /**
   Parses all arguments passed through `argc` and `argv` within the entry point.
   Exits the application if the given command-line flags are invalid.
@@ -60,7 +151,7 @@ runtime_args_t parse_args(int argc, char** argv) {
     exit(-1);
   }
 
-  runtime_args_t runtime_args = {0};
+  runtime_args_t runtime_args = {.gc_budget = VLUA_GC_BUDGET};
   for (int i = 1; i < argc; i++) {
     const char* current_arg = argv[i];
     int slashes = get_slashes(current_arg);
@@ -97,6 +188,85 @@ runtime_args_t parse_args(int argc, char** argv) {
         runtime_args.fullscreen = true;
       } else if (strcmp(current_arg, "--cut-intro") == 0) {
         runtime_args.cut_intro = true;
+      } else if (strcmp(current_arg, "--record-input") == 0) {
+        runtime_args.record_input = get_flag_value(argc, argv, &i);
+      } else if (strcmp(current_arg, "--replay-input") == 0) {
+        runtime_args.replay_input = get_flag_value(argc, argv, &i);
+      } else if (strcmp(current_arg, "--latency-probe") == 0) {
+        runtime_args.latency_probe = true;
+      } else if (strcmp(current_arg, "--headless") == 0) {
+        runtime_args.headless = true;
+      } else if (strcmp(current_arg, "--bench") == 0) {
+        long frames = strtol(get_flag_value(argc, argv, &i), NULL, 10);
+        if (frames <= 0) {
+          SYSTEM_PANIC_LOG("Expected a positive number of frames to bench!");
+          exit(-1);
+        }
+
+        runtime_args.bench_frames = frames;
+        runtime_args.cut_intro = true;
+      } else if (strcmp(current_arg, "--profile") == 0) {
+        runtime_args.profile_path = get_flag_value(argc, argv, &i);
+      } else if (strcmp(current_arg, "--trace") == 0) {
+        runtime_args.trace_path = get_flag_value(argc, argv, &i);
+      } else if (strcmp(current_arg, "--log-level") == 0) {
+        const char* level = get_flag_value(argc, argv, &i);
+        if (strcmp(level, "info") == 0) {
+          runtime_args.log_level = LOGGER_LEVEL_INFO;
+        } else if (strcmp(level, "warning") == 0) {
+          runtime_args.log_level = LOGGER_LEVEL_WARNING;
+        } else if (strcmp(level, "error") == 0) {
+          runtime_args.log_level = LOGGER_LEVEL_ERROR;
+        } else {
+          SYSTEM_PANIC_LOG("Invalid log level \"%s\"!", level);
+          exit(-1);
+        }
+      } else if (strcmp(current_arg, "--pack") == 0) {
+        runtime_args.pack_path = get_flag_value(argc, argv, &i);
+      } else if (strcmp(current_arg, "--memory-cap") == 0) {
+        long kilobytes = strtol(get_flag_value(argc, argv, &i), NULL, 10);
+        if (kilobytes <= 0) {
+          SYSTEM_PANIC_LOG("Expected a positive memory cap in kilobytes!");
+          exit(-1);
+        }
+
+        runtime_args.memory_cap = (size_t)kilobytes * 1024;
+      } else if (strcmp(current_arg, "--gc-budget") == 0) {
+        char* end;
+        const char* value = get_flag_value(argc, argv, &i);
+        double milliseconds = strtod(value, &end);
+        if (end == value || milliseconds < 0.0) {
+          SYSTEM_PANIC_LOG("Expected a GC budget of 0 or more milliseconds!");
+          exit(-1);
+        }
+
+        runtime_args.gc_budget = milliseconds / 1000;
+      } else if (strcmp(current_arg, "--jit-report") == 0) {
+        runtime_args.jit_report = true;
+      } else if (strcmp(current_arg, "--ticks") == 0) {
+        long ticks = strtol(get_flag_value(argc, argv, &i), NULL, 10);
+        if (ticks <= 0) {
+          SYSTEM_PANIC_LOG("Expected a positive number of ticks!");
+          exit(-1);
+        }
+
+        runtime_args.max_ticks = ticks;
+      } else if (strcmp(current_arg, "--instances") == 0) {
+        long instances = strtol(get_flag_value(argc, argv, &i), NULL, 10);
+        if (instances <= 0) {
+          SYSTEM_PANIC_LOG("Expected a positive number of instances!");
+          exit(-1);
+        }
+
+        runtime_args.instances = instances;
+      } else if (strcmp(current_arg, "--jobs") == 0) {
+        long jobs = strtol(get_flag_value(argc, argv, &i), NULL, 10);
+        if (jobs <= 0) {
+          SYSTEM_PANIC_LOG("Expected a positive number of jobs!");
+          exit(-1);
+        }
+
+        runtime_args.jobs = jobs;
       } else if (strcmp(current_arg, "--help") == 0) {
         display_help();
       } else {
@@ -107,16 +277,8 @@ runtime_args_t parse_args(int argc, char** argv) {
 
     default: // Attempt to parse the file path.
     {
-      int path_length = strlen(current_arg);
-      strncpy(runtime_args.game_path, current_arg, path_length);
-
-      if (current_arg[path_length - 1] == '\\' ||
-          current_arg[path_length - 1] == '/') {
-        strcat(runtime_args.game_path, "init.lua");
-      } else if (strcmp(&current_arg[path_length - 4], ".lua") != 0) {
-        strcat(runtime_args.game_path, ".lua");
-      }
-
+      free(runtime_args.game_path);
+      runtime_args.game_path = resolve_game_path(current_arg);
     } break;
     }
   }
@@ -137,22 +299,74 @@ void free_runtime(void) {
   Starts the runtime with the given command-line arguments.
 */
 int start_runtime(runtime_args_t args) {
+  if (!args.game_path) {
+    SYSTEM_PANIC_LOG("Nothing to run!");
+    return 1;
+  }
+
+  if (args.pack_path)
+    return luacart_pack(args.game_path, args.pack_path);
+
+  // clang-format off
+  vlua_args_t lua_args = {
+    .profile_path = args.profile_path,
+    .memory_cap = args.memory_cap,
+    .gc_budget = args.gc_budget,
+    .jit_report = args.jit_report
+  };
+  // clang-format on
+
+  // Initialize game window. //
+  // clang-format off
+  sys_args_t sys_args = {
+    .fullscreen = args.fullscreen,
+    .record_input = args.record_input,
+    .replay_input = args.replay_input,
+    .latency_probe = args.latency_probe,
+    .headless = args.headless,
+    .bench_frames = args.bench_frames,
+    .trace_path = args.trace_path,
+    .log_level = args.log_level,
+    .max_ticks = args.max_ticks
+  };
+  // clang-format on
+
+  if (args.instances > 0) {
+    logger_init(args.log_level);
+    // clang-format off
+    int exit_status = runner_run((runner_args_t){
+      .game_path = args.game_path,
+      .instances = args.instances,
+      .jobs = args.jobs,
+      .sys_args = sys_args,
+      .lua_args = lua_args
+    });
+    // clang-format on
+    storage_free();
+    logger_free();
+    return exit_status;
+  }
+
   if (atexit(free_runtime)) {
     SYSTEM_PANIC_LOG("%s", "Failed to register cleanup functions!");
     return 1;
   }
 
-  // Initialize game window. //
-  sys_args_t sys_args = {.fullscreen = args.fullscreen};
-  api_init(sys_args);
+  if (api_init(sys_args))
+    return 1;
 
   if (!args.cut_intro)
     intro_play();
 
+  // The window may have been closed during the intro.
+  if (!system_running()) {
+    api_free();
+    return system_exit_status();
+  }
+
   // Initialize the Lua runtime.
   SYSTEM_LOG("Executing game at %s", args.game_path);
-
-  int exit_status = vlua_init(args.game_path);
+  int exit_status = vlua_init(args.game_path, lua_args);
   if (exit_status)
     return exit_status;
 
@@ -178,7 +392,10 @@ int WinMain(void) {
   systems built in debug mode.
 */
 int main(int argc, char** argv) {
-  return start_runtime(parse_args(argc, argv));
+  runtime_args_t args = parse_args(argc, argv);
+  int exit_status = start_runtime(args);
+  free(args.game_path);
+  return exit_status;
 }
 
 #endif
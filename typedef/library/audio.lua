@@ -15,19 +15,28 @@ V-GAME's audio manager.
 The audio library contains a set of functions that allow you to generate sound
 effects and even make music.
 
-V-GAME has four audio channels to play audio within, each having their own
-distinct sound. Channel 1 has a square wave, channel 2 has a triangle wave,
-channel 3 has a sine wave, and channel 4 has noise. Whenever one channel is
-used, nothing can play on that channel until the sound on that channel has
-finished. This can cause some music and sound effects to cut off, so be
-careful.
+V-GAME has 64 audio channels to play audio within. Channel 1 has a square wave,
+channel 2 has a triangle wave, channel 3 has a sine wave, and channel 4 has
+noise. Channels 5 and up cycle through the same four waveforms, and any channel
+can be given a different waveform with the `Waveform` field. Whenever a sound
+is played on a channel, it replaces the sound that was already playing on that
+channel. This can cause some music and sound effects to cut off, so be careful.
+
+All channels are summed together by V-GAME's mixer. When many loud sounds play
+at once, the mixer turns the overall volume down and rounds off peaks instead
+of distorting.
+
+Audio calls never wait on the audio device. They are queued and picked up the
+next time the device asks for samples.
 ]]
 audio = {}
 
 ---@class AudioInfo
 ---@field Semitone integer The key in which to play a sound.
----@field Volume number The key in which to play a sound.
----@field Duration number The key in which to play a sound.
+---@field Volume number The volume of the sound, from 0 to 2.
+---@field Duration number How long the sound plays for in seconds.
+---@field Pan? number Where the sound plays from, from -1 (left) to 1 (right).
+---@field Waveform? integer The waveform to play: 1 square, 2 triangle, 3 sine or 4 noise.
 --[[
 A table that contains audio information to be given to a channel when playing
 music or sound effects.
@@ -42,3 +51,25 @@ information.
 ]]
 function audio.blip(channel, info) end
 
+
+---@param channel integer
+--[[
+Stops the sound playing within the given channel.
+]]
+function audio.stop(channel) end
+
+---@param channel integer
+---@param info AudioInfo
+--[[
+Changes the semitone, volume and/or pan of the sound playing within the given
+channel without restarting it. The duration and waveform fields are ignored.
+]]
+function audio.set(channel, info) end
+
+---@param volume number
+--[[
+Sets the volume of everything played, after every channel is mixed together.
+The volume goes from 0 to 4 and is 1 by default. Like the other audio calls,
+the change is picked up the next time the device asks for samples.
+]]
+function audio.master(volume) end
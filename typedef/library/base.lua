@@ -20,15 +20,62 @@ function assert(condition, message) end
 
 ---@param value any
 ---@param expect string
+---@return any value
 --[[
 Tests whether or not the given value matches the given type string, and will
 throw a type error if they don't match. If the given value is a table, this
 function will also test if the `__type` field within the table matches the
-given type string, otherwise, it will test it's raw type. This function is
-useful for enforcing strict type checking.
+given type string, otherwise, it will test it's raw type. Instances of classes
+made with `class()` match the name of their class and of every class it
+inherits from. This function is useful for enforcing strict type checking, and
+returns the value if it matches.
 ]]
 function check(value, expect) end
 
+---@param name string
+---@param parent? table
+---@return table
+--[[
+Creates a class with the given name, optionally inheriting the methods of a
+parent class. Methods are defined on the class once and shared by every
+instance, instead of creating new functions for every object:
+
+```lua
+local Ship = class("Ship")
+
+function Ship:init(x, y)
+  self.Position = vec2(x, y)
+end
+
+function Ship:Update() end
+
+local ship = Ship(0.5, 0.5)
+```
+
+Calling the class creates an instance and passes the arguments to its `init()`
+method if it has one. `type()` returns the class's name for its instances.
+]]
+function class(name, parent) end
+
+--[[
+If a game defines this function, V-GAME calls it once per tick after
+`update()`, then draws everything for the game. It isn't called on frames
+V-GAME skips to catch up, so it should only draw and never change game state.
+]]
+function draw() end
+
+---@param name string
+---@return any
+--[[
+Runs the module with the given name and returns whatever it returned, or true
+if it returned nothing. Modules are `.lua` files next to the game, named
+without the extension, like `import("enemies/boss")`. When running a
+cartridge, modules are loaded from inside it instead.
+
+Each module only runs once. Importing it again returns the same value.
+]]
+function import(name) end
+
 ---@generic T: table | string, V
 ---@param iterable T
 ---@return fun(iterable: V[] | string, index?: number): integer, V
@@ -116,9 +163,9 @@ function sleep(frames) end
 Returns the type of a given value unless the given value is a table.
 
 If the value is a table, it will return the value of it's `__type` field. If
-the `__type` field of a table is `nil`, then the function will return "table".
-This function will error if the `__type` field of the given table isn't a
-string!
+the `__type` field of a table is `nil`, then the function will return the name
+of the table's class if it was made by `class()`, or "table" otherwise. This
+function will error if the `__type` field of the given table isn't a string!
 ]]
 function type(value) end
 
@@ -146,12 +193,21 @@ Attempts to convert the given value to a string.
 If the given value is a table, it will first attempt to return the result of
 the table method `__tostring`. If the `__tostring` method doesn't exist within
 the table, this function will walk throught the table and return a multi-line
-string representing the table along with it's contents. If the `__tostring`
-field within the table is not a function or nil, this function will throw an
-error.
+string representing the table along with it's contents. Tables nested more
+than 32 levels deep are written as `{...}`, and strings longer than 1 MiB are
+cut short with `...`. If the `__tostring` field within the table is not a
+function or nil, this function will throw an error.
 
 If the given value is a function, the given function will be called with no
 arguments and the return value will be returned as a string.
 ]]
 function tostring(value) end
 
+---@param dt number
+--[[
+If a game defines this function, V-GAME calls it once per tick after the game
+script finishes running, with the length of a tick in seconds. Use it along
+with `draw()` instead of a `while true do ... graphics.draw() end` loop, so
+V-GAME can schedule frames itself.
+]]
+function update(dt) end
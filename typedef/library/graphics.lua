@@ -57,6 +57,9 @@ index.
 
 **This function will interrupt the program once called! This function must be
 called or else the program will freeze!**
+
+Games that define `update()` or `draw()` callbacks shouldn't call this, since
+V-GAME calls it for them after `draw()`.
 ]]
 function graphics.draw() end
 
@@ -81,16 +84,24 @@ This function is meant to be called before `graphics.draw()`.
 ]]
 function graphics.color(id) end
 
+---@param x number
+---@param y number
+---@overload fun(point: vec2)
 --[[
-Sets the current graphics position without drawing anything. This function is
-meant to be called before `graphics.draw()`.
+Sets the current graphics position without drawing anything. The position can
+also be given as a `vec2`. This function is meant to be called before
+`graphics.draw()`.
 ]]
 function graphics.move(x, y) end
 
+---@param x number
+---@param y number
+---@overload fun(point: vec2)
 --[[
 Draws a line between the current graphics position and the given position, then
-moves the current graphics position to the given position. This function is
-meant to be called before `graphics.draw()`.
+moves the current graphics position to the given position. The position can
+also be given as a `vec2`. This function is meant to be called before
+`graphics.draw()`.
 ]]
 function graphics.plot(x, y) end
 
@@ -63,23 +63,40 @@ input = {}
 ---@alias ControllerStatus {[ButtonName]: boolean}   A table containing the status of all controller buttons.
 
 ---@param button ButtonName | integer
+---@param controller? integer
 ---@return boolean
 --[[
 Returns true if the given button is being held down and false if otherwise.
+Reads from controller 1 unless another controller is given.
 ]]
-function input.pressed(button) end
+function input.pressed(button, controller) end
 
 ---@param button ButtonName | integer
+---@param controller? integer
 ---@return boolean
 --[[
 Returns true if the given button has recently been tapped and false if
 otherwise. To detect if the button is being held down, use `input.pressed`.
+Reads from controller 1 unless another controller is given.
 ]]
-function input.tapped(button) end
+function input.tapped(button, controller) end
 
+---@param controller? integer
+---@param into? ControllerStatus
 ---@return ControllerStatus
 --[[
-Returns a table containing the current status of all buttons.
+Returns a table containing the current status of all buttons. If a table is
+given, it is filled in and returned instead of creating a new one, which avoids
+allocating every frame.
 ]]
-function input.grab() end
+function input.grab(controller, into) end
+
+---@param controller? integer
+---@return integer
+--[[
+Returns the status of all buttons packed into an integer. Bit `n` is set when
+the button with input code `n + 1` is held down, so `Start` is bit 0 and `R` is
+bit 11.
+]]
+function input.mask(controller) end
 
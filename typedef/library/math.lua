@@ -11,11 +11,12 @@
 ---@class math
 ---@field PI number mathematical constant representing `pi`.
 ---@field HUGE number A mathematical constant representing the largest possible floating-point number.
+---@field f32 table The original single-precision C versions of the math functions, kept for comparison.
 --[[
-V-GAME's math library. Most of this library remains mostly the same as the Lua
-math library, except for the fact that all math functions are reduced to
-floating-point precision instead of double precision, and the math library is
-missing.
+V-GAME's math library. It works like the Lua math library with double
+precision, and LuaJIT compiles most of its functions straight into machine
+instructions. It also adds a few helpers games commonly need, like
+`math.clamp()` and `math.lerp()`.
 ]]
 math = {}
 
@@ -64,6 +65,15 @@ Returns the value rounded up to the nearest integer.
 ]]
 function math.ceil(value) end
 
+---@param value number
+---@param min number
+---@param max number
+---@return number
+--[[
+Returns the value limited to the range between `min` and `max`.
+]]
+function math.clamp(value, min, max) end
+
 ---@param radians number
 ---@return number
 --[[
@@ -93,6 +103,15 @@ function truncates the decimal places of the given value.
 ]]
 function math.floor(value) end
 
+---@param x number
+---@param y number
+---@return number
+--[[
+Returns the remainder of dividing `x` by `y`, rounding the quotient towards
+zero. Unlike `x % y`, the result has the same sign as `x`.
+]]
+function math.fmod(x, y) end
+
 ---@param value number
 ---@return number
 --[[
@@ -120,6 +139,16 @@ value.
 ]]
 function math.ldexp(m, e) end
 
+---@param a number
+---@param b number
+---@param t number
+---@return number
+--[[
+Linearly interpolates between `a` and `b`, returning `a` when `t` is 0 and `b`
+when `t` is 1.
+]]
+function math.lerp(a, b, t) end
+
 ---@param value number
 ---@return number
 --[[
@@ -150,6 +179,29 @@ Returns the lowest value out of all the given values.
 ]]
 function math.min(value, ...) end
 
+---@param base number
+---@param exponent number
+---@return number
+--[[
+Returns `base` raised to the given exponent, like `base ^ exponent`.
+]]
+function math.pow(base, exponent) end
+
+---@param value number
+---@return integer
+--[[
+Returns the value rounded to the nearest integer, with halves rounded away from
+zero.
+]]
+function math.round(value) end
+
+---@param value number
+---@return integer
+--[[
+Returns 1 if the value is positive, -1 if it's negative, or 0 if it's zero.
+]]
+function math.sign(value) end
+
 ---@param radians number
 ---@return number
 --[[
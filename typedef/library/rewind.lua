@@ -0,0 +1,54 @@
+---@meta
+
+--[[
+  rewind.lua
+
+  Made by DoelJavid for V-GAME.
+
+  https://github.com/DoelJavid/v-game
+]]
+
+---@class rewind
+--[[
+A library that steps back through the last 10 seconds of a game. The game picks
+a table holding its state with `rewind.track()`, and V-GAME snapshots it after
+every `update()`. Holding F8 rewinds the game one tick at a time, and once the
+oldest snapshot is reached the game stays paused there until F8 is released.
+
+Only what's inside the tracked table is rewound, so keep the state that should
+rewind there instead of in locals. It can hold anything `storage.save()` can.
+]]
+rewind = {}
+
+---@param frames? integer
+---@return integer rewound
+--[[
+Restores the tracked table to how it was the given number of ticks ago, or one
+tick ago if not given. Returns how many ticks were actually rewound, which is
+less than asked for once the oldest snapshot is reached.
+]]
+function rewind.back(frames) end
+
+--[[
+Snapshots the tracked table right away. Games with their own loop instead of
+`update()` should call this once per frame.
+]]
+function rewind.capture() end
+
+---@return integer
+--[[
+Returns how many ticks can be rewound.
+]]
+function rewind.frames() end
+
+---@param state table|nil
+--[[
+Starts snapshotting the given table every tick, forgetting every snapshot of
+the table tracked before. Passing nil stops tracking.
+
+Rewinding refills the table in place, so references to it stay valid, but the
+tables inside it are replaced with copies. Copies of `vec2` and `mat3` values
+and of class instances keep their type, while other tables lose their
+metatables.
+]]
+function rewind.track(state) end
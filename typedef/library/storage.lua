@@ -0,0 +1,43 @@
+---@meta
+
+--[[
+  storage.lua
+
+  Made by DoelJavid for V-GAME.
+
+  https://github.com/DoelJavid/v-game
+]]
+
+---@class storage
+--[[
+A library that keeps data like high scores and settings between runs. Each save
+has a key made of letters, digits, `-` and `_`, and is stored in a file next to
+the game.
+]]
+storage = {}
+
+---@param key string
+---@return nil|boolean|number|string|table|vec2|mat3
+--[[
+Returns the value saved under the given key, or nil if nothing was saved or the
+save is broken. Values saved earlier in the same run are returned even if they
+haven't been written to disk yet.
+]]
+function storage.load(key) end
+
+---@param key string
+---@param value nil|boolean|number|string|table|vec2|mat3
+--[[
+Saves the given value under the given key, replacing whatever was saved there
+before. Tables can hold other tables, `vec2` and `mat3` values, but not
+functions or userdata, and can't be nested more than 64 levels deep. Tables
+that appear more than once are saved as separate copies.
+
+Instances of classes made by `class()` are loaded back as instances of the
+class with the same name, as long as it's been defined by then. Other tables
+are loaded without their metatables.
+
+The save is written to disk on another thread, so saving never makes the game
+wait.
+]]
+function storage.save(key, value) end
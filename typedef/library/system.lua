@@ -15,6 +15,14 @@ console while debugging.
 ]]
 system = {}
 
+---@return number
+--[[
+Returns a timestamp in seconds with sub-microsecond precision. Only the
+difference between two timestamps is meaningful, which makes it useful for
+timing code.
+]]
+function system.clock() end
+
 ---@param ... any
 --[[
 Prints the data given to the function to the console. The printed message will
@@ -26,15 +34,47 @@ function system.error(...) end
 ---@param code? integer
 --[[
 Exits the application with exit status 0 or the given exit code if provided.
+The game stops right away, and `pcall()` can't catch it.
 ]]
 function system.exit(code) end
 
+---@return integer
+--[[
+Returns which instance of the game this is, counting from 1, when V-GAME runs
+many copies of it at once with `--instances`. Returns 0 otherwise. Each
+instance gets its own saves.
+]]
+function system.instance() end
+
 ---@param ... any
 --[[
 Prints the data given to the function to the console.
 ]]
 function system.log(...) end
 
+---@class MemoryClass
+---@field Size integer The size of every block in the class in bytes, or 0 for allocations too large for any class.
+---@field Count integer How many blocks are in use.
+---@field Bytes integer How many bytes those blocks hold.
+
+---@class MemoryStats
+---@field Used integer How many bytes the game is using.
+---@field Peak integer The most bytes the game has used at once.
+---@field Cap integer The most bytes the game can use, or 0 if there's no limit.
+---@field Reserved integer How many bytes have been set aside for small allocations.
+---@field Classes MemoryClass[] Usage of each size class, from smallest to largest.
+
+---@return MemoryStats
+--[[
+Returns how much memory the game is using. Small allocations are grouped into
+size classes, which `Classes` breaks down.
+
+A limit can be set with the `--memory-cap` flag. Going over it throws an out
+of memory error. On Lua builds that don't support custom allocators, only
+`Used` and `Peak` are filled in and `Classes` is empty.
+]]
+function system.memory() end
+
 ---@param message any
 --[[
 Throws the given error string as a fatal error and shuts down the application
@@ -42,6 +82,35 @@ if not caught by `pcall()`
 ]]
 function system.panic(message) end
 
+---@class TimingSummary
+---@field Mean number The average, in milliseconds.
+---@field P50 number The median, in milliseconds.
+---@field P95 number The 95th percentile, in milliseconds.
+---@field P99 number The 99th percentile, in milliseconds.
+---@field Max number The worst case, in milliseconds.
+---@field Count integer How many frames were measured.
+
+---@class SystemStats
+---@field FrameTime TimingSummary The time between presented frames.
+---@field Lateness TimingSummary How late frames were presented.
+---@field GC TimingSummary How long garbage collection took each frame.
+---@field Heap TimingSummary The size of the heap after each frame's garbage collection, in kilobytes instead of milliseconds.
+---@field Skipped integer How many frames were skipped to let logic catch up.
+
+---@return SystemStats
+--[[
+Returns timing statistics about recent frames.
+
+Game logic always runs at 60 ticks per second. If a game falls behind, V-GAME
+skips presenting a few frames so logic can catch up, which shows up in
+`Skipped`.
+
+Garbage is collected a little at a time while V-GAME waits to present each
+frame, which shows up in `GC` and `Heap`. How long it can take each frame is
+set with the `--gc-budget` flag.
+]]
+function system.stats() end
+
 ---@return number
 --[[
 Returns the current system tick (how many interrupts have occured).
@@ -61,3 +130,18 @@ be formatted as a warning.
 ]]
 function system.warn(...) end
 
+---@param name? string
+--[[
+Marks a section of code on the trace timeline. Calling it with a name begins a
+zone, and calling it without one ends the most recent zone. Zones can be nested
+up to 32 deep.
+
+Zones are only recorded when V-GAME is run with `--trace <file>`.
+```lua
+system.zone("physics")
+updatePhysics()
+system.zone()
+```
+]]
+function system.zone(name) end
+
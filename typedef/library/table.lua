@@ -0,0 +1,84 @@
+---@meta
+
+--[[
+  table.lua
+
+  Made by DoelJavid for V-GAME.
+
+  https://github.com/DoelJavid/v-game
+]]
+
+---@class table
+--[[
+V-GAME's table library. It has most of the Lua table library, plus functions
+for preallocating, clearing and quickly removing from tables, so lists of
+entities can be reused from frame to frame without allocating new tables.
+]]
+table = {}
+
+---@param t table
+--[[
+Removes every value from the given table while keeping the memory it already
+allocated, so refilling it doesn't need to allocate again.
+]]
+function table.clear(t) end
+
+---@param t string[]|number[]
+---@param separator? string
+---@param first? integer
+---@param last? integer
+---@return string
+--[[
+Joins the strings or numbers in the given array from `first` to `last`, which
+default to 1 and the length of the array, with the separator between each one.
+]]
+function table.concat(t, separator, first, last) end
+
+---@param t table
+---@param index integer
+---@param value any
+---@overload fun(t: table, value: any)
+--[[
+Inserts the value into the array at the given index, shifting every value after
+it up by one. If no index is given, the value is added to the end of the array.
+]]
+function table.insert(t, index, value) end
+
+---@param narray integer
+---@param nhash integer
+---@return table
+--[[
+Creates an empty table with space already allocated for `narray` array values
+and `nhash` other keys.
+]]
+function table.new(narray, nhash) end
+
+---@param t table
+---@param index? integer
+---@return any
+--[[
+Removes and returns the value at the given index of the array, shifting every
+value after it down by one. If no index is given, the last value is removed.
+]]
+function table.remove(t, index) end
+
+---@param t table
+---@param less? fun(a: any, b: any): boolean
+--[[
+Sorts the array in place. If a comparison function is given, it should return
+true when `a` has to come before `b`, otherwise values are compared with `<`.
+The sort isn't stable, so equal values may be reordered.
+]]
+function table.sort(t, less) end
+
+---@param t table
+---@param index? integer
+---@return any
+--[[
+Removes and returns the value at the given index by moving the last value of
+the array into its place. Unlike `table.remove()` this takes the same time no
+matter how long the array is, but it doesn't preserve the order of the array.
+If no index is given, the last value is removed, and nothing is removed from
+an empty array. Throws an error if the index isn't between 1 and `#t`.
+]]
+function table.swapremove(t, index) end
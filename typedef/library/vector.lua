@@ -0,0 +1,258 @@
+---@meta
+
+--[[
+  vector.lua
+
+  Made by DoelJavid for V-GAME.
+
+  https://github.com/DoelJavid/v-game
+]]
+
+---@class vec2
+---@field x number
+---@field y number
+---@operator add(vec2): vec2
+---@operator sub(vec2): vec2
+---@operator mul(vec2|number): vec2
+---@operator div(vec2|number): vec2
+---@operator unm: vec2
+--[[
+A 2-D vector. Operators like `a + b` always return a new vector, while methods
+like `a:add(b)` change the vector they're called on and return it, so they can
+be chained without allocating anything. On LuaJIT, vectors are FFI structs the
+JIT compiler can keep in registers instead of allocating.
+]]
+local Vec2 = {}
+
+---@param other vec2
+---@return vec2 self
+--[[
+Adds the other vector to this one.
+]]
+function Vec2:add(other) end
+
+---@return vec2
+--[[
+Returns a new vector with the same position.
+]]
+function Vec2:copy() end
+
+---@param other vec2
+---@return number
+--[[
+Returns the z component of the cross product of both vectors.
+]]
+function Vec2:cross(other) end
+
+---@param other vec2
+---@return number
+--[[
+Returns the distance between both vectors.
+]]
+function Vec2:distance(other) end
+
+---@param other vec2
+---@return number
+--[[
+Returns the dot product of both vectors.
+]]
+function Vec2:dot(other) end
+
+---@return number
+--[[
+Returns the length of the vector.
+]]
+function Vec2:length() end
+
+---@param other vec2
+---@param t number
+---@return vec2 self
+--[[
+Moves this vector towards the other one, reaching it when `t` is 1.
+]]
+function Vec2:lerp(other, t) end
+
+---@return vec2 self
+--[[
+Scales the vector to a length of 1. Vectors with a length of 0 are left as-is.
+]]
+function Vec2:normalize() end
+
+---@param radians number
+---@return vec2 self
+--[[
+Rotates the vector around 0, 0 by the given angle.
+]]
+function Vec2:rotate(radians) end
+
+---@param x number
+---@param y? number
+---@return vec2 self
+--[[
+Multiplies the vector by the given factors. If `y` isn't given, both
+components are multiplied by `x`.
+]]
+function Vec2:scale(x, y) end
+
+---@param x number
+---@param y number
+---@return vec2 self
+--[[
+Sets both components of the vector.
+]]
+function Vec2:set(x, y) end
+
+---@param other vec2
+---@return vec2 self
+--[[
+Subtracts the other vector from this one.
+]]
+function Vec2:sub(other) end
+
+---@overload fun(x?: number, y?: number): vec2
+--[[
+Creates 2-D vectors. Calling `vec2(x, y)` returns a new vector, and any
+component not given is 0.
+]]
+vec2 = {}
+
+---@param value any
+---@return boolean
+--[[
+Returns true if the given value is a `vec2`.
+]]
+function vec2.is(value) end
+
+---@class mat3
+---@field m11 number
+---@field m12 number
+---@field m13 number
+---@field m21 number
+---@field m22 number
+---@field m23 number
+---@operator mul(mat3): mat3
+---@operator mul(vec2): vec2
+--[[
+A 3x3 matrix describing a 2-D transform. The last row is always `0, 0, 1`, so
+only the first two rows are stored. `a * b` returns a new matrix applying `b`
+first and then `a`, and `m * point` returns a new transformed vector.
+
+Methods like `m:rotate()` change the matrix they're called on and return it,
+and apply their transform before the ones already in the matrix, so
+`m:translate(x, y):rotate(r)` rotates points and then moves them.
+]]
+local Mat3 = {}
+
+---@param point vec2
+---@return vec2 point
+--[[
+Transforms the given vector in place.
+]]
+function Mat3:apply(point) end
+
+---@param points vec2[]
+---@return vec2[] points
+--[[
+Transforms every vector in the given array in place.
+]]
+function Mat3:applyAll(points) end
+
+---@return mat3
+--[[
+Returns a new matrix with the same transform.
+]]
+function Mat3:copy() end
+
+---@return mat3 self
+--[[
+Resets the matrix to a transform that doesn't change anything.
+]]
+function Mat3:identity() end
+
+---@return mat3 self
+--[[
+Replaces the matrix with the transform that undoes it.
+]]
+function Mat3:invert() end
+
+---@param other mat3
+---@return mat3 self
+--[[
+Multiplies this matrix by the other one, so the other one's transform is
+applied first.
+]]
+function Mat3:multiply(other) end
+
+---@param radians number
+---@return mat3 self
+--[[
+Adds a rotation around 0, 0 by the given angle.
+]]
+function Mat3:rotate(radians) end
+
+---@param x number
+---@param y? number
+---@return mat3 self
+--[[
+Adds a scale by the given factors. If `y` isn't given, both axes are scaled by
+`x`.
+]]
+function Mat3:scale(x, y) end
+
+---@param points vec2[]
+---@param out? vec2[]
+---@return vec2[] out
+--[[
+Writes every vector in `points` transformed into `out`, which is created if not
+given. Vectors already in `out` are reused, so passing the same array every
+frame doesn't allocate anything.
+]]
+function Mat3:transformAll(points, out) end
+
+---@param x number
+---@param y number
+---@return mat3 self
+--[[
+Adds a translation by the given offset.
+]]
+function Mat3:translate(x, y) end
+
+---@overload fun(): mat3
+---@overload fun(m11: number, m12: number, m13: number, m21: number, m22: number, m23: number): mat3
+--[[
+Creates 2-D transforms. Calling `mat3()` returns a matrix that doesn't change
+anything, and `mat3(m11, m12, m13, m21, m22, m23)` returns one with the given
+first two rows.
+]]
+mat3 = {}
+
+---@param value any
+---@return boolean
+--[[
+Returns true if the given value is a `mat3`.
+]]
+function mat3.is(value) end
+
+---@param radians number
+---@return mat3
+--[[
+Returns a new matrix rotating around 0, 0 by the given angle.
+]]
+function mat3.rotation(radians) end
+
+---@param x number
+---@param y? number
+---@return mat3
+--[[
+Returns a new matrix scaling by the given factors. If `y` isn't given, both
+axes are scaled by `x`.
+]]
+function mat3.scaling(x, y) end
+
+---@param x number
+---@param y number
+---@return mat3
+--[[
+Returns a new matrix moving points by the given offset.
+]]
+function mat3.translation(x, y) end